@@ -0,0 +1,438 @@
+#include "audiodecoderthread.h"
+#include "streamcapture.h"
+#include "streamrecorder.h"
+#include "threadpolicy.h"
+#include <QDebug>
+#include <QtEndian>
+#include <QTcpSocket>
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QMediaDevices>
+#include <QAudioDevice>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
+}
+
+static inline quint32 read_be32(const uchar *data) {
+    quint32 val;
+    memcpy(&val, data, 4);
+    return qFromBigEndian(val);
+}
+
+static inline quint64 read_be64(const uchar *data) {
+    quint64 val;
+    memcpy(&val, data, 8);
+    return qFromBigEndian(val);
+}
+
+AudioDecoderThread::AudioDecoderThread(int baseLatencyMs, QObject *parent)
+    : QThread(parent), mRunning(false), m_jitterBuffer(baseLatencyMs), m_compensationPpm(0)
+{
+}
+
+AudioDecoderThread::~AudioDecoderThread()
+{
+    stop();
+    quit();
+    wait();
+    cleanup();
+}
+
+void AudioDecoderThread::stop()
+{
+    mRunning = false;
+}
+
+void AudioDecoderThread::attachSocket(QTcpSocket *socket, const QSharedPointer<StreamRecorder> &recorder)
+{
+    if (!socket) return;
+
+    // A QObject can only change threads when it has no parent
+    socket->setParent(nullptr);
+    socket->moveToThread(this);
+
+    QMetaObject::invokeMethod(socket, [this, socket, recorder]() {
+        if (m_audioSocket) {
+            // A new stream after a reconnect: it starts with its codec id and
+            // config again, which reopens the decoder
+            m_audioSocket->disconnect();
+            m_audioSocket->abort();
+            delete m_audioSocket;
+            m_capture.reset();
+            m_state = STATE_READING_CODEC_ID;
+            m_headerFilled = 0;
+            m_payloadFilled = 0;
+        }
+        m_recorder = recorder;
+        m_audioSocket = socket;
+        connect(socket, &QTcpSocket::readyRead, socket, [this]() { readFromSocket(); });
+        readFromSocket();
+    }, Qt::QueuedConnection);
+}
+
+AudioDecoderThread::Stats AudioDecoderThread::stats() const
+{
+    Stats stats;
+    stats.bufferedMs = m_jitterBuffer.levelMs();
+    stats.targetMs = m_jitterBuffer.targetMs();
+    stats.underruns = m_jitterBuffer.underruns();
+    stats.droppedMs = m_jitterBuffer.droppedMs();
+    stats.compensationPpm = m_compensationPpm.loadRelaxed();
+    return stats;
+}
+
+void AudioDecoderThread::run()
+{
+    mRunning = true;
+    ThreadPolicy::instance().applyToCurrentThread(ThreadPolicy::AudioDecode);
+
+    m_packet = av_packet_alloc();
+    m_frame = av_frame_alloc();
+    if (!m_packet || !m_frame) {
+        ThreadPolicy::instance().releaseCurrentThread();
+        emit audioFinished("Audio initialization failed");
+        return;
+    }
+
+    QAudioFormat format;
+    format.setSampleRate(AudioJitterBuffer::SAMPLE_RATE);
+    format.setChannelCount(AudioJitterBuffer::CHANNELS);
+    format.setSampleFormat(QAudioFormat::Int16);
+
+    // The sink lives in this thread, so GUI stalls cannot starve the sound card
+    QAudioSink *sink = nullptr;
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    if (device.isNull() || !device.isFormatSupported(format)) {
+        qWarning() << "[Audio] No output device for 48 kHz stereo, audio is drained but not played";
+    } else {
+        // Unbuffered: QIODevice's read-ahead would hide samples from the drift and underrun accounting
+        m_jitterBuffer.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        sink = new QAudioSink(device, format);
+        // Keep the device-side buffer small; the jitter buffer holds the slack
+        sink->setBufferSize(static_cast<qsizetype>(AudioJitterBuffer::bytesForMs(20)));
+        sink->start(&m_jitterBuffer);
+    }
+
+    emit audioFinished("Audio ready");
+    exec();
+
+    if (sink) {
+        sink->stop();
+        delete sink;
+    }
+    m_jitterBuffer.close();
+
+    // The socket lives in this thread, so it must also be destroyed here
+    if (m_audioSocket) {
+        m_audioSocket->abort();
+        delete m_audioSocket;
+        m_audioSocket = nullptr;
+    }
+
+    cleanup();
+    ThreadPolicy::instance().releaseCurrentThread();
+    emit audioFinished("Audio stopped");
+}
+
+void AudioDecoderThread::cleanup()
+{
+    if (m_swrContext) {
+        swr_free(&m_swrContext);
+    }
+    if (m_codecContext) {
+        avcodec_free_context(&m_codecContext);
+    }
+    if (m_frame) {
+        av_frame_free(&m_frame);
+    }
+    if (m_packet) {
+        av_packet_free(&m_packet);
+    }
+}
+
+void AudioDecoderThread::readFromSocket()
+{
+    if (!m_audioSocket) return;
+
+    while (mRunning && m_audioSocket->bytesAvailable() > 0) {
+        if (m_state == STATE_DISABLED) {
+            m_audioSocket->readAll();
+            return;
+        }
+
+        const int headerSize = (m_state == STATE_READING_CODEC_ID) ? 4 : 12;
+        char *region;
+        qint64 capacity;
+        if (m_state == STATE_READING_PACKET_PAYLOAD) {
+            region = m_payload.data() + m_payloadFilled;
+            capacity = m_payloadSize - m_payloadFilled;
+        } else {
+            region = reinterpret_cast<char*>(m_headerBuffer) + m_headerFilled;
+            capacity = headerSize - m_headerFilled;
+        }
+
+        const qint64 bytesRead = m_audioSocket->read(region, capacity);
+        if (bytesRead <= 0) break;
+
+        if (m_capture) {
+            m_capture->write(StreamCapture::AudioChannel, region, bytesRead);
+        }
+
+        if (m_state == STATE_READING_PACKET_PAYLOAD) {
+            m_payloadFilled += static_cast<quint32>(bytesRead);
+            if (m_payloadFilled == m_payloadSize) {
+                m_state = STATE_READING_PACKET_HEADER;
+                decodePayload();
+            }
+        } else {
+            m_headerFilled += static_cast<int>(bytesRead);
+            if (m_headerFilled == headerSize) {
+                m_headerFilled = 0;
+                if (!handleHeader()) {
+                    m_state = STATE_DISABLED;
+                }
+            }
+        }
+    }
+}
+
+bool AudioDecoderThread::handleHeader()
+{
+    if (m_state == STATE_READING_CODEC_ID) {
+        m_codecId = read_be32(m_headerBuffer);
+        switch (m_codecId) {
+        case CODEC_ID_OPUS:
+        case CODEC_ID_AAC:
+        case CODEC_ID_FLAC:
+        case CODEC_ID_RAW:
+            if (m_recorder) {
+                m_recorder->setStreamCodec(StreamRecorder::AudioStream, avCodecId());
+            }
+            m_state = STATE_READING_PACKET_HEADER;
+            return true;
+        case CODEC_ID_DISABLED:
+            qDebug() << "[Audio] Audio disabled by the device";
+            break;
+        case CODEC_ID_ERROR:
+            emit errorOccurred("Audio capture failed on the device");
+            break;
+        default:
+            emit errorOccurred(QString("Unsupported audio codec id: 0x%1").arg(m_codecId, 8, 16, QChar('0')));
+            break;
+        }
+        // The recording must not wait for a stream that never comes
+        if (m_recorder) {
+            m_recorder->disableStream(StreamRecorder::AudioStream);
+        }
+        return false;
+    }
+
+    const quint64 ptsAndFlags = read_be64(m_headerBuffer);
+    const quint32 size = read_be32(m_headerBuffer + 8);
+    if (size == 0) {
+        return true;
+    }
+    if (size > MAX_PACKET_SIZE) {
+        emit errorOccurred(QString("Invalid audio packet size: %1").arg(size));
+        return false;
+    }
+
+    m_packetIsConfig = (ptsAndFlags & PACKET_FLAG_CONFIG) != 0;
+    m_packetPts = m_packetIsConfig ? -1 : static_cast<qint64>(ptsAndFlags & PACKET_PTS_MASK);
+
+    // Grows to the largest packet once; libavcodec needs zeroed padding after the data
+    const int required = static_cast<int>(size) + AV_INPUT_BUFFER_PADDING_SIZE;
+    if (m_payload.size() < required) {
+        m_payload.resize(required);
+    }
+    memset(m_payload.data() + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    m_payloadSize = size;
+    m_payloadFilled = 0;
+    m_state = STATE_READING_PACKET_PAYLOAD;
+    return true;
+}
+
+int AudioDecoderThread::avCodecId() const
+{
+    switch (m_codecId) {
+    case CODEC_ID_OPUS: return AV_CODEC_ID_OPUS;
+    case CODEC_ID_AAC:  return AV_CODEC_ID_AAC;
+    case CODEC_ID_FLAC: return AV_CODEC_ID_FLAC;
+    default:            return AV_CODEC_ID_PCM_S16LE;
+    }
+}
+
+bool AudioDecoderThread::openDecoder()
+{
+    const AVCodecID codecId = static_cast<AVCodecID>(avCodecId());
+
+    const AVCodec *codec = avcodec_find_decoder(codecId);
+    if (!codec) {
+        emit errorOccurred("Audio decoder not found");
+        return false;
+    }
+
+    m_codecContext = avcodec_alloc_context3(codec);
+    if (!m_codecContext) {
+        emit errorOccurred("Failed to allocate audio codec context");
+        return false;
+    }
+
+    // scrcpy always captures 48 kHz stereo
+    m_codecContext->sample_rate = AudioJitterBuffer::SAMPLE_RATE;
+    av_channel_layout_default(&m_codecContext->ch_layout, AudioJitterBuffer::CHANNELS);
+    if (codecId == AV_CODEC_ID_PCM_S16LE) {
+        m_codecContext->sample_fmt = AV_SAMPLE_FMT_S16;
+    }
+    m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+
+    if (!m_extradata.isEmpty()) {
+        m_codecContext->extradata = static_cast<uint8_t*>(
+            av_mallocz(static_cast<size_t>(m_extradata.size()) + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (m_codecContext->extradata) {
+            memcpy(m_codecContext->extradata, m_extradata.constData(), static_cast<size_t>(m_extradata.size()));
+            m_codecContext->extradata_size = m_extradata.size();
+        }
+    }
+
+    if (avcodec_open2(m_codecContext, codec, nullptr) < 0) {
+        emit errorOccurred("Failed to open audio codec");
+        avcodec_free_context(&m_codecContext);
+        return false;
+    }
+    return true;
+}
+
+void AudioDecoderThread::decodePayload()
+{
+    if (m_packetIsConfig) {
+        // Codec setup (OpusHead, AudioSpecificConfig, STREAMINFO) goes into the
+        // extradata of a freshly opened decoder
+        m_extradata = QByteArray(m_payload.constData(), static_cast<int>(m_payloadSize));
+        if (m_recorder) {
+            m_recorder->setExtradata(StreamRecorder::AudioStream, m_extradata);
+        }
+        if (m_codecContext) {
+            avcodec_free_context(&m_codecContext);
+        }
+        if (!openDecoder()) {
+            m_state = STATE_DISABLED;
+        }
+        return;
+    }
+
+    if (!m_codecContext && !openDecoder()) {
+        m_state = STATE_DISABLED;
+        return;
+    }
+
+    m_packet->data = reinterpret_cast<uint8_t*>(m_payload.data());
+    m_packet->size = static_cast<int>(m_payloadSize);
+    m_packet->pts = m_packetPts;
+    m_packet->dts = m_packetPts;
+
+    // The payload buffer is reused, so the recorder gets its own copy
+    if (m_recorder) {
+        m_recorder->pushPacket(StreamRecorder::AudioStream, m_packet);
+    }
+    if (avcodec_send_packet(m_codecContext, m_packet) >= 0) {
+        while (avcodec_receive_frame(m_codecContext, m_frame) == 0) {
+            playFrame(m_frame);
+            av_frame_unref(m_frame);
+        }
+    }
+    av_packet_unref(m_packet);
+}
+
+void AudioDecoderThread::playFrame(AVFrame *frame)
+{
+    if (!setupResampler(frame)) {
+        return;
+    }
+
+    const int maxFrames = swr_get_out_samples(m_swrContext, frame->nb_samples);
+    if (maxFrames <= 0) {
+        return;
+    }
+    const int required = maxFrames * AudioJitterBuffer::BYTES_PER_FRAME;
+    if (m_pcm.size() < required) {
+        m_pcm.resize(required);
+    }
+
+    uint8_t *out[] = { reinterpret_cast<uint8_t*>(m_pcm.data()) };
+    const int frames = swr_convert(m_swrContext, out, maxFrames,
+                                   const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+    if (frames <= 0) {
+        return;
+    }
+
+    m_jitterBuffer.writeSamples(m_pcm.constData(), qint64(frames) * AudioJitterBuffer::BYTES_PER_FRAME);
+    updateDriftCompensation(frames);
+}
+
+bool AudioDecoderThread::setupResampler(AVFrame *frame)
+{
+    if (m_swrContext
+        && m_swrInputFormat == frame->format
+        && m_swrInputRate == frame->sample_rate
+        && m_swrInputChannels == frame->ch_layout.nb_channels) {
+        return true;
+    }
+
+    swr_free(&m_swrContext);
+
+    AVChannelLayout outLayout;
+    av_channel_layout_default(&outLayout, AudioJitterBuffer::CHANNELS);
+    int ret = swr_alloc_set_opts2(&m_swrContext,
+                                  &outLayout, AV_SAMPLE_FMT_S16, AudioJitterBuffer::SAMPLE_RATE,
+                                  &frame->ch_layout, static_cast<AVSampleFormat>(frame->format),
+                                  frame->sample_rate, 0, nullptr);
+    av_channel_layout_uninit(&outLayout);
+    if (ret < 0 || !m_swrContext) {
+        emit errorOccurred("Failed to allocate audio resampler");
+        return false;
+    }
+
+    // Always run the resampler, so drift compensation needs no re-init later
+    av_opt_set_int(m_swrContext, "flags", SWR_FLAG_RESAMPLE, 0);
+    if (swr_init(m_swrContext) < 0) {
+        swr_free(&m_swrContext);
+        emit errorOccurred("Failed to initialize audio resampler");
+        return false;
+    }
+
+    m_swrInputFormat = frame->format;
+    m_swrInputRate = frame->sample_rate;
+    m_swrInputChannels = frame->ch_layout.nb_channels;
+    m_averageError = 0.0;
+    m_framesSinceCompensation = 0;
+    m_compensationPpm.storeRelaxed(0);
+    return true;
+}
+
+void AudioDecoderThread::updateDriftCompensation(int frames)
+{
+    // Smooth out the packet-sized steps of the buffer level
+    m_averageError = 0.9 * m_averageError + 0.1 * m_jitterBuffer.levelErrorFrames();
+
+    m_framesSinceCompensation += frames;
+    if (m_framesSinceCompensation < COMPENSATION_INTERVAL) {
+        return;
+    }
+    m_framesSinceCompensation = 0;
+
+    // Remove a quarter of the excess (or deficit) per second, within the bound
+    const int distance = AudioJitterBuffer::SAMPLE_RATE;
+    const int maxDelta = distance * MAX_COMPENSATION_PERMILLE / 1000;
+    const int delta = qBound(-maxDelta, static_cast<int>(-m_averageError / 4), maxDelta);
+
+    if (swr_set_compensation(m_swrContext, delta, distance) >= 0) {
+        m_compensationPpm.storeRelaxed(static_cast<int>(-qint64(delta) * 1000000 / distance));
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef AUDIODECODERTHREAD_H
+#define AUDIODECODERTHREAD_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QSharedPointer>
+#include "audiojitterbuffer.h"
+
+// Forward declarations
+class QTcpSocket;
+class StreamCapture;
+class StreamRecorder;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwrContext;
+
+/**
+ * @class AudioDecoderThread
+ * @brief Reads, decodes and plays the scrcpy audio stream on its own thread.
+ *
+ * The audio socket carries a 4-byte codec id followed by packets framed like
+ * the video stream (12-byte header, then payload). Packets are decoded with
+ * libavcodec (opus, aac, flac or raw PCM), converted by swresample to s16
+ * stereo 48 kHz and queued in an AudioJitterBuffer that a QAudioSink, also
+ * living in this thread, pulls from.
+ *
+ * Clock drift between the device and the sound card shows up as a slowly
+ * rising or falling buffer level. The resampler compensates for it by
+ * stretching or squeezing the audio by at most MAX_COMPENSATION_PERMILLE,
+ * which keeps the playback delay constant. Video frames are displayed on
+ * arrival, so audio stays in sync with the video.
+ */
+class AudioDecoderThread : public QThread
+{
+    Q_OBJECT
+public:
+    /**
+     * @param baseLatencyMs The jitter buffer's base target level (the audio_buffer option).
+     */
+    explicit AudioDecoderThread(int baseLatencyMs, QObject *parent = nullptr);
+    ~AudioDecoderThread();
+
+    void stop();
+
+    /**
+     * @brief Hands the connected audio socket over to this thread, which takes ownership of it.
+     *
+     * Attaching again after a reconnect replaces the old socket and starts over
+     * with the new stream, which goes into @p recorder (may be null); see
+     * VideoDecoderThread::attachSocket().
+     */
+    void attachSocket(QTcpSocket *socket, const QSharedPointer<StreamRecorder> &recorder);
+
+    /**
+     * @brief Tees the raw socket bytes into a capture file for replay. Call before start().
+     */
+    void setCapture(const QSharedPointer<StreamCapture> &capture) { m_capture = capture; }
+
+    struct Stats {
+        int bufferedMs = 0;      // Current jitter buffer level
+        int targetMs = 0;        // Current (adaptive) target level
+        quint64 underruns = 0;   // Times the sink ran dry
+        quint64 droppedMs = 0;   // Audio discarded to bound latency
+        int compensationPpm = 0; // Current drift correction, positive = playing faster
+    };
+
+    /**
+     * @brief Returns the playback statistics. Thread-safe.
+     */
+    Stats stats() const;
+
+signals:
+    void audioFinished(const QString &message);
+    void errorOccurred(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    void readFromSocket();
+    bool handleHeader();
+    int avCodecId() const;
+    bool openDecoder();
+    void decodePayload();
+    void playFrame(AVFrame *frame);
+    bool setupResampler(AVFrame *frame);
+    void updateDriftCompensation(int frames);
+    void cleanup();
+
+    enum StreamingState {
+        STATE_READING_CODEC_ID,
+        STATE_READING_PACKET_HEADER,
+        STATE_READING_PACKET_PAYLOAD,
+        STATE_DISABLED
+    };
+
+    // scrcpy audio codec ids (big-endian ASCII tags)
+    static constexpr quint32 CODEC_ID_DISABLED = 0;
+    static constexpr quint32 CODEC_ID_ERROR = 1;
+    static constexpr quint32 CODEC_ID_OPUS = 0x6f707573; // "opus"
+    static constexpr quint32 CODEC_ID_AAC = 0x00616163;  // "aac"
+    static constexpr quint32 CODEC_ID_FLAC = 0x666c6163; // "flac"
+    static constexpr quint32 CODEC_ID_RAW = 0x00726177;  // "raw"
+
+    static constexpr quint64 PACKET_FLAG_CONFIG = quint64(1) << 63;
+    static constexpr quint64 PACKET_PTS_MASK = (quint64(1) << 62) - 1;
+    static constexpr quint32 MAX_PACKET_SIZE = 1024 * 1024;
+
+    // Drift compensation: evaluated every COMPENSATION_INTERVAL frames and applied
+    // over the following second, bounded to 0.5% speed change
+    static constexpr int COMPENSATION_INTERVAL = AudioJitterBuffer::SAMPLE_RATE / 10;
+    static constexpr int MAX_COMPENSATION_PERMILLE = 5;
+
+    volatile bool mRunning;
+    AudioJitterBuffer m_jitterBuffer;
+    QTcpSocket *m_audioSocket = nullptr; // Owned and used by this thread only
+
+    StreamingState m_state = STATE_READING_CODEC_ID;
+    uchar m_headerBuffer[12];
+    int m_headerFilled = 0;
+    QByteArray m_payload;                // Reused; sized to the largest packet plus padding
+    quint32 m_payloadSize = 0;
+    quint32 m_payloadFilled = 0;
+    bool m_packetIsConfig = false;
+    qint64 m_packetPts = -1;
+
+    quint32 m_codecId = 0;
+    QByteArray m_extradata;              // From the last config packet
+    AVCodecContext *m_codecContext = nullptr;
+    AVPacket *m_packet = nullptr;
+    AVFrame *m_frame = nullptr;
+    SwrContext *m_swrContext = nullptr;
+    int m_swrInputFormat = -1;
+    int m_swrInputRate = 0;
+    int m_swrInputChannels = 0;
+    QByteArray m_pcm;                    // Reused conversion output
+    QSharedPointer<StreamRecorder> m_recorder;
+    QSharedPointer<StreamCapture> m_capture;
+
+    double m_averageError = 0.0;         // Smoothed jitter buffer error, in frames
+    int m_framesSinceCompensation = 0;
+    QAtomicInt m_compensationPpm;
+};
+
+#endif // AUDIODECODERTHREAD_H
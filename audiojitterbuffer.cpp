@@ -0,0 +1,148 @@
+#include "audiojitterbuffer.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+
+AudioJitterBuffer::AudioJitterBuffer(int baseLatencyMs, QObject *parent)
+    : QIODevice(parent),
+      m_ring(static_cast<int>(bytesForMs(CAPACITY_MS))),
+      m_baseTargetMs(qBound(10, baseLatencyMs, MAX_TARGET_MS)),
+      m_targetMs(m_baseTargetMs)
+{
+    m_sinceUnderrun.start();
+}
+
+void AudioJitterBuffer::writeSamples(const char *data, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 capacity = m_ring.size();
+    if (bytes > capacity) {
+        // Only the newest second can be kept anyway
+        m_droppedBytes += bytes - capacity;
+        data += bytes - capacity;
+        bytes = capacity;
+    }
+    if (m_level + bytes > capacity) {
+        discard(m_level + bytes - capacity);
+    }
+
+    // Copy into the ring, wrapping at most once
+    qint64 writePos = (m_readPos + m_level) % capacity;
+    const qint64 first = qMin(bytes, capacity - writePos);
+    memcpy(m_ring.data() + writePos, data, static_cast<size_t>(first));
+    memcpy(m_ring.data(), data + first, static_cast<size_t>(bytes - first));
+    m_level += bytes;
+
+    // A burst (e.g. after a network stall) would otherwise be played late forever
+    const qint64 maxLevel = bytesForMs(m_targetMs + MAX_EXCESS_MS);
+    if (!m_buffering && m_level > maxLevel) {
+        discard(m_level - bytesForMs(m_targetMs));
+    }
+
+    // Let the target decay after a long stable period
+    if (m_targetMs > m_baseTargetMs && m_sinceUnderrun.elapsed() > TARGET_DECAY_AFTER_MS) {
+        m_targetMs = qMax(m_baseTargetMs, m_targetMs - TARGET_DECAY_STEP_MS);
+        m_sinceUnderrun.restart();
+    }
+}
+
+void AudioJitterBuffer::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_readPos = 0;
+    m_level = 0;
+    m_buffering = true;
+}
+
+int AudioJitterBuffer::levelErrorFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_buffering) {
+        return 0;
+    }
+    return static_cast<int>((m_level - bytesForMs(m_targetMs)) / BYTES_PER_FRAME);
+}
+
+int AudioJitterBuffer::levelMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return msForBytes(m_level);
+}
+
+int AudioJitterBuffer::targetMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_targetMs;
+}
+
+quint64 AudioJitterBuffer::underruns() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_underruns;
+}
+
+quint64 AudioJitterBuffer::droppedMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<quint64>(msForBytes(static_cast<qint64>(m_droppedBytes)));
+}
+
+qint64 AudioJitterBuffer::bytesAvailable() const
+{
+    // The sink never starves on this device: missing audio is replaced by silence
+    return bytesForMs(10) + QIODevice::bytesAvailable();
+}
+
+qint64 AudioJitterBuffer::readData(char *data, qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+
+    maxSize -= maxSize % BYTES_PER_FRAME;
+    if (maxSize <= 0) {
+        return 0;
+    }
+
+    if (m_buffering) {
+        if (m_level < bytesForMs(m_targetMs)) {
+            memset(data, 0, static_cast<size_t>(maxSize));
+            return maxSize;
+        }
+        m_buffering = false;
+    }
+
+    const qint64 capacity = m_ring.size();
+    const qint64 bytes = qMin(maxSize, m_level);
+    const qint64 first = qMin(bytes, capacity - m_readPos);
+    memcpy(data, m_ring.constData() + m_readPos, static_cast<size_t>(first));
+    memcpy(data + first, m_ring.constData(), static_cast<size_t>(bytes - first));
+    m_readPos = (m_readPos + bytes) % capacity;
+    m_level -= bytes;
+
+    if (bytes < maxSize) {
+        // Underrun: pad with silence, re-buffer and aim for a higher level
+        memset(data + bytes, 0, static_cast<size_t>(maxSize - bytes));
+        m_underruns++;
+        m_buffering = true;
+        m_targetMs = qMin(MAX_TARGET_MS, m_targetMs + qMax(10, m_baseTargetMs / 2));
+        m_sinceUnderrun.restart();
+        qDebug() << "[AudioJitterBuffer] Underrun, target raised to" << m_targetMs << "ms";
+    }
+
+    return maxSize;
+}
+
+qint64 AudioJitterBuffer::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1; // Fed through writeSamples()
+}
+
+void AudioJitterBuffer::discard(qint64 bytes)
+{
+    bytes = qMin(bytes - bytes % BYTES_PER_FRAME, m_level);
+    m_readPos = (m_readPos + bytes) % m_ring.size();
+    m_level -= bytes;
+    m_droppedBytes += static_cast<quint64>(bytes);
+}
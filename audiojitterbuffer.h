@@ -0,0 +1,97 @@
+#ifndef AUDIOJITTERBUFFER_H
+#define AUDIOJITTERBUFFER_H
+
+#include <QIODevice>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QVector>
+
+/**
+ * @file audiojitterbuffer.h
+ * @brief Defines the AudioJitterBuffer class, the adaptive buffer between the audio decoder and the sound card.
+ */
+
+/**
+ * @class AudioJitterBuffer
+ * @brief A sequential QIODevice holding decoded PCM (s16, stereo, 48 kHz) until the audio sink pulls it.
+ *
+ * The buffer absorbs network jitter while keeping latency close to a target level:
+ * - Playback starts (and restarts after an underrun) only once the target level
+ *   is buffered; until then the sink reads silence.
+ * - Every underrun raises the target, so a jittery link settles on a level that
+ *   plays without gaps. After a long run without underruns the target decays
+ *   back towards the configured base latency.
+ * - A burst that pushes the level far above the target is trimmed, so latency
+ *   cannot build up; small, slow deviations (clock drift) are corrected by the
+ *   decoder's resampler using levelErrorFrames().
+ *
+ * The decoder writes with writeSamples() while the sink reads from its own
+ * thread; all members are protected by a mutex.
+ */
+class AudioJitterBuffer : public QIODevice
+{
+    Q_OBJECT
+public:
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 2;
+    static constexpr int BYTES_PER_FRAME = CHANNELS * 2; // s16 interleaved
+
+    static constexpr qint64 bytesForMs(int ms) { return qint64(ms) * SAMPLE_RATE / 1000 * BYTES_PER_FRAME; }
+
+    explicit AudioJitterBuffer(int baseLatencyMs, QObject *parent = nullptr);
+
+    /**
+     * @brief Appends decoded samples. Called by the decoder thread.
+     */
+    void writeSamples(const char *data, qint64 bytes);
+
+    /**
+     * @brief Drops all buffered audio and restarts pre-buffering.
+     */
+    void reset();
+
+    /**
+     * @brief Buffered level minus target level, in frames; positive means too much latency.
+     * @return 0 while pre-buffering (no playback clock to compare against).
+     */
+    int levelErrorFrames() const;
+
+    // Statistics
+    int levelMs() const;
+    int targetMs() const;
+    quint64 underruns() const;
+    quint64 droppedMs() const;
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    static constexpr int CAPACITY_MS = 1000;
+    static constexpr int MAX_TARGET_MS = 500;
+    static constexpr int MAX_EXCESS_MS = 150;       // Trim when level exceeds target by this much
+    static constexpr int TARGET_DECAY_AFTER_MS = 10000;
+    static constexpr int TARGET_DECAY_STEP_MS = 5;
+
+    static int msForBytes(qint64 bytes) { return int(bytes / BYTES_PER_FRAME * 1000 / SAMPLE_RATE); }
+
+    void discard(qint64 bytes);
+
+    mutable QMutex m_mutex;
+    QVector<char> m_ring;
+    qint64 m_readPos = 0;
+    qint64 m_level = 0;
+    bool m_buffering = true;
+
+    int m_baseTargetMs;
+    int m_targetMs;
+    QElapsedTimer m_sinceUnderrun;
+
+    quint64 m_underruns = 0;
+    quint64 m_droppedBytes = 0;
+};
+
+#endif // AUDIOJITTERBUFFER_H
@@ -0,0 +1,59 @@
+QT       = core gui network
+
+CONFIG += c++17 console simd
+CONFIG -= app_bundle
+
+TARGET = decoderbench
+
+# Benchmarks the client's own sources, not copies of them
+ROOT_PATH = $$PWD/..
+REPLAY_PATH = $$ROOT_PATH/tools/scrcpy-replay
+INCLUDEPATH += $$ROOT_PATH $$REPLAY_PATH
+
+SOURCES += \
+    $$ROOT_PATH/decoderprofile.cpp \
+    $$ROOT_PATH/decoderthreadbudget.cpp \
+    $$ROOT_PATH/framechangedetector.cpp \
+    $$ROOT_PATH/framemailbox.cpp \
+    $$ROOT_PATH/framepool.cpp \
+    $$ROOT_PATH/latencytracker.cpp \
+    $$ROOT_PATH/streamcapture.cpp \
+    $$ROOT_PATH/streamrecorder.cpp \
+    $$ROOT_PATH/threadpolicy.cpp \
+    $$ROOT_PATH/videodecoderthread.cpp \
+    $$ROOT_PATH/yuvconverter.cpp \
+    $$ROOT_PATH/yuvkernels_neon.cpp \
+    $$REPLAY_PATH/syntheticstream.cpp \
+    decoderbenchmark.cpp \
+    main.cpp
+
+SSE4_1_SOURCES += $$ROOT_PATH/yuvkernels_sse41.cpp
+AVX2_SOURCES += $$ROOT_PATH/yuvkernels_avx2.cpp
+
+HEADERS += \
+    $$ROOT_PATH/decoderprofile.h \
+    $$ROOT_PATH/decoderthreadbudget.h \
+    $$ROOT_PATH/framechangedetector.h \
+    $$ROOT_PATH/framemailbox.h \
+    $$ROOT_PATH/framepool.h \
+    $$ROOT_PATH/latencytracker.h \
+    $$ROOT_PATH/streamcapture.h \
+    $$ROOT_PATH/streamrecorder.h \
+    $$ROOT_PATH/threadpolicy.h \
+    $$ROOT_PATH/videodecoderthread.h \
+    $$ROOT_PATH/yuvconverter.h \
+    $$ROOT_PATH/yuvkernels.h \
+    $$ROOT_PATH/yuvkernels_impl.h \
+    $$REPLAY_PATH/syntheticstream.h \
+    decoderbenchmark.h
+
+# ===================================================================
+# FFmpeg Integration
+# ===================================================================
+FFMPEG_PATH = $$ROOT_PATH/3rdparty/ffmpeg
+INCLUDEPATH += $$FFMPEG_PATH/include
+LIBS += -L$$FFMPEG_PATH/lib \
+        -lavformat \
+        -lavcodec \
+        -lavutil \
+        -lswscale
@@ -0,0 +1,273 @@
+#include "decoderbenchmark.h"
+#include "syntheticstream.h"
+#include "videodecoderthread.h"
+#include "yuvconverter.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+static QJsonObject sizeFields(const QSize &size)
+{
+    return QJsonObject{{"width", size.width()}, {"height", size.height()}};
+}
+
+static QJsonObject merged(QJsonObject object, const QJsonObject &extra)
+{
+    for (auto it = extra.begin(); it != extra.end(); ++it) {
+        object.insert(it.key(), it.value());
+    }
+    return object;
+}
+
+DecoderBenchmark::DecoderBenchmark(const Options &options)
+    : m_options(options)
+{
+}
+
+QJsonObject DecoderBenchmark::run()
+{
+    QJsonArray parse;
+    QJsonArray decode;
+    QJsonArray convert;
+
+    for (const QSize &size : std::as_const(m_options.resolutions)) {
+        for (const QString &codec : std::as_const(m_options.codecs)) {
+            SyntheticStream::Settings settings;
+            settings.size = size;
+            settings.fps = m_options.fps;
+            settings.bitRate = m_options.bitRate;
+            settings.codec = codec;
+            settings.gop = m_options.fps;
+            settings.loopSeconds = 2;
+
+            SyntheticStream stream;
+            QString error;
+            if (!stream.encode(settings, &error)) {
+                qWarning().noquote() << "[Bench] Skipping" << codec << size << ":" << error;
+                decode.append(merged(sizeFields(size), {{"codec", codec}, {"error", error}}));
+                continue;
+            }
+
+            qInfo().noquote() << "[Bench] parse/decode" << codec << size;
+            for (const QJsonValue &entry : benchmarkParse(stream)) {
+                parse.append(entry);
+            }
+            for (const QString &profile : std::as_const(m_options.profiles)) {
+                decode.append(benchmarkDecode(stream, profile));
+            }
+        }
+
+        qInfo().noquote() << "[Bench] convert" << size;
+        for (const QJsonValue &entry : benchmarkConvert(size)) {
+            convert.append(entry);
+        }
+    }
+
+    return QJsonObject{
+        {"ffmpeg", QString::fromLatin1(av_version_info())},
+        {"qt", QString::fromLatin1(qVersion())},
+        {"yuv_kernels_compiled", QJsonArray::fromStringList(YuvConverter::compiledKernels())},
+        {"yuv_kernels_selected", QString::fromLatin1(YuvConverter::kernelName())},
+        {"iterations", m_options.iterations},
+        {"parse", parse},
+        {"decode", decode},
+        {"convert", convert},
+    };
+}
+
+QByteArray DecoderBenchmark::framedStream(const SyntheticStream &stream)
+{
+    QByteArray bytes = stream.preamble("Benchmark");
+    for (int i = 0; i < stream.loopFrames(); ++i) {
+        bytes += stream.packet(i);
+    }
+    return bytes;
+}
+
+QJsonArray DecoderBenchmark::benchmarkParse(const SyntheticStream &stream)
+{
+    QJsonArray results;
+    const QByteArray bytes = framedStream(stream);
+    const uchar *data = reinterpret_cast<const uchar*>(bytes.constData());
+    const qint64 size = bytes.size();
+
+    for (int chunkSize : std::as_const(m_options.chunkSizes)) {
+        qint64 totalNs = 0;
+        for (int i = 0; i < m_options.iterations; ++i) {
+            // A fresh parser per pass, since the stream starts with its preamble.
+            // Without an open decoder, payloads are demuxed and then dropped.
+            VideoDecoderThread decoder(stream.settings().codec);
+            decoder.mRunning = true;
+
+            QElapsedTimer timer;
+            timer.start();
+            for (qint64 offset = 0; offset < size; offset += chunkSize) {
+                decoder.processBuffer(data + offset, qMin<qint64>(chunkSize, size - offset));
+            }
+            totalNs += timer.nsecsElapsed();
+        }
+
+        const double seconds = qMax<qint64>(1, totalNs) / 1e9;
+        const double packets = double(stream.loopFrames()) * m_options.iterations;
+        results.append(merged(sizeFields(stream.settings().size), {
+            {"codec", stream.settings().codec},
+            {"chunk_size", chunkSize},
+            {"stream_bytes", size},
+            {"mb_per_s", double(size) * m_options.iterations / seconds / 1e6},
+            {"ns_per_packet", totalNs / packets},
+        }));
+    }
+    return results;
+}
+
+QJsonObject DecoderBenchmark::benchmarkDecode(const SyntheticStream &stream, const QString &profile)
+{
+    const SyntheticStream::Settings &settings = stream.settings();
+    QJsonObject result = merged(sizeFields(settings.size), {{"codec", settings.codec}, {"profile", profile}});
+
+    VideoDecoderThread decoder(settings.codec);
+    decoder.setProfile(DecoderProfile::fromName(profile));
+    if (!decoder.initializeDecoder()) {
+        result.insert("error", "decoder initialization failed");
+        return result;
+    }
+
+    // Payloads are prepared up front (with libavcodec's zeroed padding), so only
+    // decoding is timed. The config goes in front of the first packet, as the parser does.
+    const int frames = stream.loopFrames() * m_options.iterations;
+    QList<QByteArray> payloads;
+    payloads.reserve(frames);
+    for (int i = 0; i < frames; ++i) {
+        QByteArray payload = (i == 0) ? stream.config() + stream.payload(i) : stream.payload(i);
+        payload.append(QByteArray(AV_INPUT_BUFFER_PADDING_SIZE, '\0'));
+        payloads.append(payload);
+    }
+
+    AVCodecContext *context = decoder.m_codecContext;
+    AVPacket *packet = decoder.m_packet;
+    AVFrame *frame = decoder.m_frame;
+    int decoded = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        packet->data = reinterpret_cast<uint8_t*>(payloads[i].data());
+        packet->size = static_cast<int>(payloads[i].size() - AV_INPUT_BUFFER_PADDING_SIZE);
+        packet->pts = i;
+        if (avcodec_send_packet(context, packet) >= 0) {
+            while (avcodec_receive_frame(context, frame) == 0) {
+                decoded++;
+                av_frame_unref(frame);
+            }
+        }
+    }
+    // Frame threading holds frames back; they count towards the total
+    avcodec_send_packet(context, nullptr);
+    while (avcodec_receive_frame(context, frame) == 0) {
+        decoded++;
+        av_frame_unref(frame);
+    }
+    const qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    result.insert("decoder", QString::fromLatin1(context->codec->name));
+    result.insert("threads", context->thread_count);
+    result.insert("thread_type", context->active_thread_type == FF_THREAD_FRAME ? "frame"
+                                 : context->active_thread_type == FF_THREAD_SLICE ? "slice" : "none");
+    result.insert("frames", decoded);
+    result.insert("fps", decoded / (elapsedNs / 1e9));
+    result.insert("ms_per_frame", decoded > 0 ? elapsedNs / 1e6 / decoded : 0.0);
+    return result;
+}
+
+QJsonArray DecoderBenchmark::benchmarkConvert(const QSize &size)
+{
+    QJsonArray results;
+    const int conversions = 30 * m_options.iterations;
+
+    for (const QString &formatName : std::as_const(m_options.pixelFormats)) {
+        const AVPixelFormat format = av_get_pix_fmt(formatName.toLatin1().constData());
+        AVFrame *frame = av_frame_alloc();
+        frame->format = format;
+        frame->width = size.width();
+        frame->height = size.height();
+        if (format == AV_PIX_FMT_NONE || av_frame_get_buffer(frame, 0) < 0) {
+            results.append(merged(sizeFields(size), {{"pixel_format", formatName}, {"error", "unsupported format"}}));
+            av_frame_free(&frame);
+            continue;
+        }
+
+        // Any content will do for swscale, whose cost does not depend on it
+        for (int plane = 0; plane < AV_NUM_DATA_POINTERS && frame->buf[plane]; ++plane) {
+            uint8_t *bytes = frame->buf[plane]->data;
+            for (size_t i = 0; i < frame->buf[plane]->size; ++i) {
+                bytes[i] = static_cast<uint8_t>(i * 7);
+            }
+        }
+
+        // Full resolution, and the half-size viewport that triggers scaling, each
+        // through YuvConverter's kernels (where they apply) and through swscale alone
+        for (const QSize &target : {QSize(), size / 2}) {
+            for (const QString &quality : std::as_const(m_options.scaleQualities)) {
+                // One probe per case: whether it converts at all, and whether the kernels apply.
+                // The first call also builds the swscale context, so it is not timed.
+                bool viaKernels = false;
+                {
+                    YuvConverter::setEnabled(true);
+                    VideoDecoderThread probe("h264");
+                    probe.setScaleQuality(quality);
+                    probe.setTargetSize(target);
+                    if (probe.convertFrameToImage(frame).isNull()) {
+                        const QSize requested = target.isEmpty() ? size : target;
+                        results.append(merged(sizeFields(size), {
+                            {"pixel_format", formatName},
+                            {"scale_quality", quality},
+                            {"output_width", requested.width()},
+                            {"output_height", requested.height()},
+                            {"error", "conversion failed"},
+                        }));
+                        continue;
+                    }
+                    viaKernels = probe.m_lastKernelFormat != -1;
+                }
+
+                // Without kernels for this case, only the swscale pass measures it
+                const QList<bool> passes = viaKernels ? QList<bool>{true, false} : QList<bool>{false};
+                for (bool useKernels : passes) {
+                    YuvConverter::setEnabled(useKernels);
+                    VideoDecoderThread decoder("h264");
+                    decoder.setScaleQuality(quality);
+                    decoder.setTargetSize(target);
+
+                    const QImage warmUp = decoder.convertFrameToImage(frame);
+                    const QSize outputSize = warmUp.size();
+
+                    QElapsedTimer timer;
+                    timer.start();
+                    for (int i = 0; i < conversions; ++i) {
+                        // Released at once, so the frame pool never runs dry
+                        decoder.convertFrameToImage(frame);
+                    }
+                    const qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+                    results.append(merged(sizeFields(size), {
+                        {"pixel_format", formatName},
+                        {"scale_quality", quality},
+                        {"converter", QString::fromLatin1(useKernels ? YuvConverter::kernelName() : "swscale")},
+                        {"output_width", outputSize.width()},
+                        {"output_height", outputSize.height()},
+                        {"ms_per_frame", elapsedNs / 1e6 / conversions},
+                        {"ns_per_pixel", double(elapsedNs) / conversions / (size.width() * size.height())},
+                    }));
+                }
+            }
+        }
+        YuvConverter::setEnabled(true);
+        av_frame_free(&frame);
+    }
+    return results;
+}
@@ -0,0 +1,60 @@
+#ifndef DECODERBENCHMARK_H
+#define DECODERBENCHMARK_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QSize>
+#include <QStringList>
+
+class SyntheticStream;
+
+/**
+ * @file decoderbenchmark.h
+ * @brief Defines the DecoderBenchmark class, microbenchmarks of the video hot path.
+ */
+
+/**
+ * @class DecoderBenchmark
+ * @brief Measures the demux parser, the decoder and the frame conversion of VideoDecoderThread.
+ *
+ * Input streams are encoded test patterns (SyntheticStream from
+ * tools/scrcpy-replay). The benchmarks call VideoDecoderThread's private
+ * stages directly (it declares this class a friend), on the calling thread:
+ * - parse:   processBuffer() with the decoder left closed, per chunk size
+ * - decode:  the decoder context as initializeDecoder() configures it, per DecoderProfile
+ * - convert: convertFrameToImage() per pixel format, scale quality and output size,
+ *            with YuvConverter's kernels and with swscale alone
+ *
+ * Results are returned as JSON, one array per benchmark.
+ */
+class DecoderBenchmark
+{
+public:
+    struct Options {
+        QStringList codecs = {"h264", "h265"};
+        QList<QSize> resolutions = {QSize(1280, 720), QSize(1920, 1080)};
+        QList<int> chunkSizes = {1500, 16384, 65536, 1048576};
+        QStringList pixelFormats = {"yuv420p", "nv12", "yuv420p10le", "p010le"};
+        QStringList scaleQualities = {"fast", "bilinear", "bicubic"};
+        QStringList profiles = {"low-latency", "balanced", "throughput"};
+        int fps = 60;
+        qint64 bitRate = 8000000;
+        int iterations = 5;
+    };
+
+    explicit DecoderBenchmark(const Options &options);
+
+    QJsonObject run();
+
+private:
+    QJsonArray benchmarkParse(const SyntheticStream &stream);
+    QJsonObject benchmarkDecode(const SyntheticStream &stream, const QString &profile);
+    QJsonArray benchmarkConvert(const QSize &size);
+
+    static QByteArray framedStream(const SyntheticStream &stream);
+
+    Options m_options;
+};
+
+#endif // DECODERBENCHMARK_H
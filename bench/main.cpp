@@ -0,0 +1,67 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonDocument>
+#include <QDebug>
+#include "decoderbenchmark.h"
+
+// Microbenchmarks of the video hot path (demux, decode, conversion) with JSON output,
+// so changes to VideoDecoderThread can be compared run against run.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("decoderbench");
+
+    DecoderBenchmark::Options options;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks VideoDecoderThread's parser, decoder and frame conversion.");
+    parser.addHelpOption();
+    QCommandLineOption outputOption({"o", "output"}, "Write the JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption codecsOption("codecs", "Comma-separated codecs (default h264,h265).", "list");
+    QCommandLineOption resolutionsOption("resolutions", "Comma-separated sizes (default 1280x720,1920x1080).", "list");
+    QCommandLineOption iterationsOption("iterations", "Repetitions per measurement (default 5).", "count");
+    parser.addOptions({outputOption, codecsOption, resolutionsOption, iterationsOption});
+    parser.process(app);
+
+    if (parser.isSet(codecsOption)) {
+        options.codecs = parser.value(codecsOption).split(',', Qt::SkipEmptyParts);
+    }
+    if (parser.isSet(resolutionsOption)) {
+        options.resolutions.clear();
+        for (const QString &item : parser.value(resolutionsOption).split(',', Qt::SkipEmptyParts)) {
+            const QStringList parts = item.split('x');
+            const QSize size = parts.size() == 2 ? QSize(parts.at(0).toInt(), parts.at(1).toInt()) : QSize();
+            if (size.width() < 16 || size.height() < 16) {
+                qCritical() << "Invalid resolution:" << item;
+                return 1;
+            }
+            options.resolutions.append(size);
+        }
+    }
+    if (parser.isSet(iterationsOption)) {
+        options.iterations = parser.value(iterationsOption).toInt();
+        if (options.iterations <= 0) {
+            qCritical() << "Invalid iteration count:" << parser.value(iterationsOption);
+            return 1;
+        }
+    }
+
+    DecoderBenchmark benchmark(options);
+    const QByteArray json = QJsonDocument(benchmark.run()).toJson();
+
+    if (!parser.isSet(outputOption)) {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+        return 0;
+    }
+
+    QFile file(parser.value(outputOption));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        qCritical() << "Cannot write" << file.fileName() << ":" << file.errorString();
+        return 1;
+    }
+    qInfo() << "[Bench] Results written to" << file.fileName();
+    return 0;
+}
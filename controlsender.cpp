@@ -184,3 +184,12 @@ void ControlSender::postCollapseNotificationPanel()
     buffer.append(CONTROL_MSG_TYPE_COLLAPSE_NOTIFICATION_PANEL);
     send(buffer);
 }
+
+void ControlSender::postResetVideo()
+{
+    // Message structure for RESET_VIDEO:
+    // [type: 1 byte]
+    QByteArray buffer;
+    buffer.append(CONTROL_MSG_TYPE_RESET_VIDEO);
+    send(buffer);
+}
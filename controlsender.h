@@ -33,6 +33,7 @@ enum ControlMsgType {
     CONTROL_MSG_TYPE_SET_CLIPBOARD,           // Sets the device's clipboard content.
     CONTROL_MSG_TYPE_SET_SCREEN_POWER_MODE,   // Sets the screen power mode (e.g., off, on).
     CONTROL_MSG_TYPE_ROTATE_DEVICE,           // Rotates the device screen.
+    CONTROL_MSG_TYPE_RESET_VIDEO = 17,        // Restarts the video encoder, which resends the config and a key frame (scrcpy 3.x numbering).
 };
 
 /**
@@ -142,6 +143,11 @@ public:
      * @brief Sends a command to collapse the notification panel.
      */
     void postCollapseNotificationPanel();
+
+    /**
+     * @brief Asks the server to restart video encoding, so a fresh key frame arrives at once.
+     */
+    void postResetVideo();
     // ... Other commands can be added here as needed, following the scrcpy protocol.
 
 signals:
@@ -0,0 +1,34 @@
+#include "decoderprofile.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+DecoderProfile DecoderProfile::fromName(const QString &name, bool *ok)
+{
+    DecoderProfile profile;
+    profile.skipLoopFilter = AVDISCARD_DEFAULT;
+    if (ok) {
+        *ok = true;
+    }
+
+    if (name == "low-latency") {
+        profile.name = name;
+        profile.frameThreading = DecoderThreadBudget::FrameThreading::Never;
+        profile.skipLoopFilter = AVDISCARD_NONREF;
+    } else if (name == "throughput") {
+        profile.name = name;
+        profile.frameThreading = DecoderThreadBudget::FrameThreading::Always;
+        profile.lowDelay = false;
+        profile.fast = false;
+        profile.displayQueueDepth = 3;
+    } else if (name != "balanced" && ok) {
+        *ok = false;
+    }
+    return profile;
+}
+
+QStringList DecoderProfile::names()
+{
+    return {"low-latency", "balanced", "throughput"};
+}
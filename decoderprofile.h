@@ -0,0 +1,49 @@
+#ifndef DECODERPROFILE_H
+#define DECODERPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include "decoderthreadbudget.h"
+
+/**
+ * @file decoderprofile.h
+ * @brief Defines DecoderProfile, the latency-versus-throughput trade-offs of a video decoder.
+ */
+
+/**
+ * @struct DecoderProfile
+ * @brief How a VideoDecoderThread trades latency for throughput and fidelity.
+ *
+ * - low-latency: one frame in flight. Slice threads only (frame threading
+ *   holds a frame back per thread), AV_CODEC_FLAG_LOW_DELAY, and the loop
+ *   filter is skipped on non-reference frames, whose artifacts do not
+ *   propagate. Only the newest frame is displayed.
+ * - balanced (default): frame threading only for very large frames, where
+ *   slice threads stop scaling; full-quality decoding; newest frame displayed.
+ * - throughput: frame threading whenever the session gets more than one
+ *   thread, bit-exact decoding (no AV_CODEC_FLAG2_FAST), and a short display
+ *   queue, so every frame is shown unless the GUI falls behind by more than
+ *   it. For recording and analysis, where a few frames of delay do not matter.
+ *
+ * Values that map to FFmpeg enums are kept as ints, so this header does not
+ * depend on libavcodec.
+ */
+struct DecoderProfile
+{
+    QString name = "balanced";
+    DecoderThreadBudget::FrameThreading frameThreading = DecoderThreadBudget::FrameThreading::LargeFrames;
+    bool lowDelay = true;       // AV_CODEC_FLAG_LOW_DELAY, ignored while frame threading is used
+    bool fast = true;           // AV_CODEC_FLAG2_FAST: speedups that are not bit-exact
+    int skipLoopFilter = 0;     // AVDiscard for skip_loop_filter
+    int displayQueueDepth = 1;  // Frames waiting for the GUI, see FrameMailbox
+
+    /**
+     * @brief Returns the profile called @p name ("low-latency", "balanced" or "throughput").
+     * @param ok Set to false, if given, when the name is unknown; the balanced profile is returned then.
+     */
+    static DecoderProfile fromName(const QString &name, bool *ok = nullptr);
+
+    static QStringList names();
+};
+
+#endif // DECODERPROFILE_H
@@ -0,0 +1,116 @@
+#include "decoderthreadbudget.h"
+#include <QDebug>
+#include <QThread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+DecoderThreadBudget &DecoderThreadBudget::instance()
+{
+    static DecoderThreadBudget budget;
+    return budget;
+}
+
+int DecoderThreadBudget::registerSession(const QSize &resolution, bool visible, FrameThreading frameThreading)
+{
+    QMutexLocker locker(&mMutex);
+    const int id = mNextId++;
+    Session session;
+    session.resolution = resolution;
+    session.visible = visible;
+    session.frameThreading = frameThreading;
+    mSessions.insert(id, session);
+    rebalance();
+    return id;
+}
+
+void DecoderThreadBudget::unregisterSession(int id)
+{
+    QMutexLocker locker(&mMutex);
+    if (mSessions.remove(id) > 0) {
+        rebalance();
+    }
+}
+
+void DecoderThreadBudget::setResolution(int id, const QSize &resolution)
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mSessions.find(id);
+    if (it == mSessions.end() || it->resolution == resolution) {
+        return;
+    }
+    it->resolution = resolution;
+    rebalance();
+}
+
+void DecoderThreadBudget::setVisible(int id, bool visible)
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mSessions.find(id);
+    if (it == mSessions.end() || it->visible == visible) {
+        return;
+    }
+    it->visible = visible;
+    rebalance();
+}
+
+DecoderThreadBudget::Allocation DecoderThreadBudget::allocationFor(int id) const
+{
+    QMutexLocker locker(&mMutex);
+    return mSessions.value(id).allocation;
+}
+
+int DecoderThreadBudget::threadBudget() const
+{
+    return qMax(1, QThread::idealThreadCount() - RESERVED_CORES);
+}
+
+void DecoderThreadBudget::rebalance()
+{
+    auto pixelsOf = [](const Session &session) -> qint64 {
+        return session.resolution.isEmpty()
+            ? DEFAULT_PIXELS
+            : qint64(session.resolution.width()) * session.resolution.height();
+    };
+
+    const int budget = threadBudget();
+    qint64 totalPixels = 0;
+    int visibleSessions = 0;
+    for (const Session &session : std::as_const(mSessions)) {
+        if (session.visible) {
+            totalPixels += pixelsOf(session);
+            visibleSessions++;
+        }
+    }
+
+    bool changed = false;
+    for (Session &session : mSessions) {
+        Allocation allocation;
+        allocation.threadType = FF_THREAD_SLICE;
+        if (session.visible) {
+            const qint64 pixels = pixelsOf(session);
+            const int share = static_cast<int>(budget * pixels / totalPixels);
+            if (share >= 2 && session.frameThreading == FrameThreading::Always) {
+                allocation.threadType = FF_THREAD_FRAME;
+                allocation.threadCount = qMin(share, MAX_SLICE_THREADS);
+            } else if (share >= 2 && session.frameThreading == FrameThreading::LargeFrames
+                       && pixels >= FRAME_THREADING_MIN_PIXELS) {
+                allocation.threadType = FF_THREAD_FRAME;
+                allocation.threadCount = qMin(share, MAX_FRAME_THREADS);
+            } else {
+                allocation.threadCount = qBound(1, share, MAX_SLICE_THREADS);
+            }
+        }
+        if (allocation != session.allocation) {
+            session.allocation = allocation;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        mGeneration.fetchAndAddRelease(1);
+        qDebug() << "[DecoderThreadBudget]" << budget << "threads shared by" << visibleSessions
+                 << "visible of" << mSessions.size() << "sessions";
+    }
+}
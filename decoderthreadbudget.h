@@ -0,0 +1,112 @@
+#ifndef DECODERTHREADBUDGET_H
+#define DECODERTHREADBUDGET_H
+
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QSize>
+
+/**
+ * @file decoderthreadbudget.h
+ * @brief Defines the DecoderThreadBudget class, which shares the host's cores between the video decoders.
+ */
+
+/**
+ * @class DecoderThreadBudget
+ * @brief Assigns every decoding session a libavcodec thread count and threading type.
+ *
+ * Left to auto-detection, each decoder starts about one worker per core, so
+ * a dozen sessions oversubscribe the host many times over and spend their
+ * time context switching. Instead, the cores (less one for the GUI and the
+ * sockets) are split between the visible sessions in proportion to their
+ * resolution. Hidden sessions only decode reference frames (see
+ * VideoDecoderThread::setPresentationEnabled()) and get a single thread.
+ *
+ * Sessions use slice threading, which adds no delay. Only very large frames
+ * that get more than one thread use frame threading, capped at a few threads
+ * since each one holds back a frame. A session's FrameThreading (from its
+ * DecoderProfile) can rule frame threading out, or use it at any size.
+ *
+ * Every change bumps generation(); decoders compare it on key frames and
+ * reopen their codec when their allocation changed. Thread-safe.
+ */
+class DecoderThreadBudget
+{
+public:
+    struct Allocation
+    {
+        int threadCount = 1;
+        int threadType = 0;     // FF_THREAD_SLICE or FF_THREAD_FRAME
+
+        bool operator==(const Allocation &other) const
+        {
+            return threadCount == other.threadCount && threadType == other.threadType;
+        }
+        bool operator!=(const Allocation &other) const { return !(*this == other); }
+    };
+
+    enum class FrameThreading {
+        Never,          // Slice threads only: no frame is held back
+        LargeFrames,    // From FRAME_THREADING_MIN_PIXELS on, capped at MAX_FRAME_THREADS
+        Always          // Whenever the share is two threads or more, capped like slice threads
+    };
+
+    static DecoderThreadBudget &instance();
+
+    /**
+     * @brief Adds a decoding session.
+     * @param resolution The stream's resolution, or an empty size if not known yet.
+     * @return The session id to pass to the other calls.
+     */
+    int registerSession(const QSize &resolution, bool visible,
+                        FrameThreading frameThreading = FrameThreading::LargeFrames);
+
+    /**
+     * @brief Removes a session; its threads are handed to the others. Unknown ids are ignored.
+     */
+    void unregisterSession(int id);
+
+    void setResolution(int id, const QSize &resolution);
+    void setVisible(int id, bool visible);
+
+    Allocation allocationFor(int id) const;
+
+    /**
+     * @brief Incremented whenever the allocations may have changed.
+     */
+    int generation() const { return mGeneration.loadAcquire(); }
+
+    /**
+     * @brief Threads shared by the visible sessions.
+     */
+    int threadBudget() const;
+
+private:
+    DecoderThreadBudget() = default;
+    Q_DISABLE_COPY(DecoderThreadBudget)
+
+    struct Session
+    {
+        QSize resolution;
+        bool visible = true;
+        FrameThreading frameThreading = FrameThreading::LargeFrames;
+        Allocation allocation;
+    };
+
+    // Recomputes every allocation; called with mMutex held
+    void rebalance();
+
+    // Weight of a session whose resolution is not known yet
+    static constexpr int DEFAULT_PIXELS = 1920 * 1080;
+    static constexpr int RESERVED_CORES = 1;
+    static constexpr int MAX_SLICE_THREADS = 8;
+    static constexpr int MAX_FRAME_THREADS = 3;
+    static constexpr int FRAME_THREADING_MIN_PIXELS = 2560 * 1440;
+
+    mutable QMutex mMutex;
+    QMap<int, Session> mSessions;
+    int mNextId = 1;
+    QAtomicInt mGeneration{0};
+};
+
+#endif // DECODERTHREADBUDGET_H
@@ -1,6 +1,9 @@
 #include "devicewindow.h"
 #include "ui_devicewindow.h"
 #include "videodecoderthread.h"
+#include "audiodecoderthread.h"
+#include "streamcapture.h"
+#include "streamrecorder.h"
 #include <QCloseEvent>
 #include <QDebug>
 #include <QTimer>
@@ -9,21 +12,30 @@
 #include <QDir>
 #include <QFile>
 #include <QMouseEvent>
+#include <QWindow>
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QDateTime>
+#include <QRandomGenerator>
 #include "androidkeycodes.h"
+#include "portallocator.h"
+#include "serverjarcache.h"
+#include "videowidget.h"
 
 DeviceWindow::DeviceWindow(const QString &serial, const ScrcpyOptions &options, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::DeviceWindow),
     mSerial(serial),
     mOptions(options),
-    mLocalPort(27183),
+    mLocalPort(options.direct_port != 0 ? options.direct_port : PortAllocator::instance().acquire(serial)),
     mConnectionRetries(0),
     mCurrentFrameSize(0, 0)
 {
     ui->setupUi(this);
+
+    // A per-session id gives every server its own abstract socket, so several
+    // devices (or several sessions on one device) never share a forward target.
+    mOptions.scid = static_cast<qint32>(QRandomGenerator::global()->bounded(0x7FFFFFFF));
     setWindowIcon(QIcon(":/assert/title.ico"));
 
     // Apply window settings
@@ -42,20 +54,17 @@ DeviceWindow::DeviceWindow(const QString &serial, const ScrcpyOptions &options,
     }
     setWindowFlags(flags);
 
-    // OPTIMIZATION: Pre-configure video label for best performance
-    ui->label_videoStream->setStyleSheet("color: white; background-color: black;");
-    ui->label_videoStream->setAlignment(Qt::AlignCenter);
-    ui->label_videoStream->setText(tr("Connecting to device..."));
+    ui->widget_videoStream->setText(tr("Connecting to device..."));
 
-    // CRITICAL: Enable automatic scaling - this is KEY for performance
-    // QLabel will handle scaling internally using hardware acceleration
-    ui->label_videoStream->setScaledContents(true);
+    connect(ui->widget_videoStream, &VideoWidget::viewportResized,
+            this, &DeviceWindow::onViewportResized);
+    connect(ui->widget_videoStream, &VideoWidget::framePresented,
+            this, &DeviceWindow::onFramePresented);
 
     setupToolbarActions();
     this->setFocusPolicy(Qt::StrongFocus);
 
-    // Delay start to allow window initialization
-    QTimer::singleShot(100, this, &DeviceWindow::startStreaming);
+    // Bring-up (startStreaming) is started by the SessionScheduler
 
     // Handle fullscreen after window is shown
     if (mOptions.fullscreen) {
@@ -66,9 +75,13 @@ DeviceWindow::DeviceWindow(const QString &serial, const ScrcpyOptions &options,
         });
     }
 
-#ifdef QT_DEBUG
-    mLastFpsTime = QDateTime::currentMSecsSinceEpoch();
-#endif
+    mMetricsTimer = new QTimer(this);
+    mMetricsTimer->setInterval(DisplayConfig::METRICS_INTERVAL_MS);
+    connect(mMetricsTimer, &QTimer::timeout, this, &DeviceWindow::sampleMetrics);
+
+    mReconnectTimer = new QTimer(this);
+    mReconnectTimer->setSingleShot(true);
+    connect(mReconnectTimer, &QTimer::timeout, this, &DeviceWindow::reconnect);
 }
 
 DeviceWindow::~DeviceWindow()
@@ -85,8 +98,19 @@ QString DeviceWindow::getSerial() const
 
 void DeviceWindow::showError(const QString &title, const QString &message, bool fatal)
 {
+    // A failed reconnect attempt is retried, not reported
+    if (fatal && mReconnectAttempt > 0 && !mStopping) {
+        onConnectionLost(QString("%1: %2").arg(title, message));
+        return;
+    }
+
     qCritical() << "[DeviceWindow]" << mSerial << "-" << title << ":" << message;
 
+    // Free the scheduler slot before the (modal) message box
+    if (fatal) {
+        reportBringUp(false);
+    }
+
     if (isVisible()) {
         QMessageBox::critical(this, title, message);
     }
@@ -100,53 +124,7 @@ void DeviceWindow::closeEvent(QCloseEvent *event)
 {
     qDebug() << "[DeviceWindow] Closing window for" << mSerial;
 
-    // Handle recording file pull with SAFE this pointer
-    if (!mOptions.record_file.isEmpty()) {
-        QString format = (mOptions.record_format == "auto" ? "mkv" : mOptions.record_format);
-        QString device_path = QString("/sdcard/%1.%2").arg("temp_record_file").arg(format);
-        QString pc_path = mOptions.record_file;
-
-        qDebug() << "[DeviceWindow] Pulling recording from" << device_path << "to" << pc_path;
-
-        AdbProcess *pullProcess = new AdbProcess();
-
-        // CRITICAL FIX: Use QPointer to safely capture 'this'
-        QPointer<DeviceWindow> safeThis(this);
-
-        connect(pullProcess, &AdbProcess::finished, pullProcess,
-                [safeThis, pullProcess, device_path, pc_path](int exitCode, QProcess::ExitStatus status){
-                    if (status == QProcess::NormalExit && exitCode == 0) {
-                        qInfo() << "[DeviceWindow] Record file pulled successfully";
-
-                        // Only show message if window still exists
-                        if (safeThis) {
-                            QMessageBox::information(safeThis, tr("Recording Successful"),
-                                                     tr("The recording has been saved to:\n%1").arg(QDir::toNativeSeparators(pc_path)));
-                        }
-
-                        // Delete temp file from device
-                        AdbProcess *rmProcess = new AdbProcess();
-                        connect(rmProcess, &AdbProcess::finished, rmProcess, &QObject::deleteLater);
-
-                        if (safeThis) {
-                            rmProcess->execute(safeThis->mSerial, {"shell", "rm", device_path});
-                        } else {
-                            rmProcess->deleteLater();
-                        }
-                    } else {
-                        qWarning() << "[DeviceWindow] Failed to pull record file:" << pullProcess->getOutput();
-
-                        if (safeThis) {
-                            QMessageBox::warning(safeThis, tr("Recording Failed"),
-                                                 tr("Could not pull the recording from the device.\n") + pullProcess->getOutput());
-                        }
-                    }
-                    pullProcess->deleteLater();
-                });
-
-        pullProcess->execute(mSerial, {"pull", device_path, pc_path});
-    }
-
+    reportBringUp(false); // No-op unless closed while still connecting
     stopAll();
     emit windowClosed(mSerial);
     event->accept();
@@ -154,9 +132,37 @@ void DeviceWindow::closeEvent(QCloseEvent *event)
 
 void DeviceWindow::startStreaming()
 {
-    ui->label_videoStream->setText(tr("Step 1: Pushing server..."));
-    qDebug() << "[DeviceWindow] Step 1: Pushing server file";
+    mBringUpClock.start();
+    mStageTimings.clear();
+    mBringUpReported = false;
+    mStaleJarRetried = false;
+
+    if (mLocalPort == 0) {
+        showError(tr("Fatal Error"),
+                  tr("No free local port is available for this device.\n"
+                     "Close some device windows and try again."),
+                  true);
+        return;
+    }
+
+    // A replay server (or any local scrcpy-protocol server) is already
+    // listening: there is nothing to push, forward or start
+    if (mOptions.direct_port != 0) {
+        qDebug() << "[DeviceWindow] Direct connection to port" << mLocalPort;
+        mServerStartedMs = 0;
+        mConnectionRetries = 0;
+        mConnectStartedMs = -1;
+        beginConnecting();
+        return;
+    }
+
+    // Push and forward are independent of each other, so run them concurrently;
+    // the server is started once both have completed.
+    ui->widget_videoStream->setText(tr("Step 1: Pushing server and forwarding port..."));
+    qDebug() << "[DeviceWindow] Step 1: Pushing server file and forwarding port";
+    mPendingSetupSteps = 2;
     pushServer();
+    forwardPort();
 }
 
 void DeviceWindow::pushServer()
@@ -171,10 +177,41 @@ void DeviceWindow::pushServer()
         return;
     }
 
-    const QString serverRemotePath = "/data/local/tmp/scrcpy-server.jar";
-    AdbProcess *pushProcess = new AdbProcess(this);
-    connect(pushProcess, &AdbProcess::finished, this, &DeviceWindow::onPushServerFinished);
-    pushProcess->execute(mSerial, {"push", serverLocalPath, serverRemotePath});
+    mServerJarHash = ServerJarCache::localHash(serverLocalPath);
+    mServerPushSkipped = false;
+
+    // Fast path: this device was already verified to hold this exact jar
+    if (!mServerJarHash.isEmpty() && ServerJarCache::knownDeviceHash(mSerial) == mServerJarHash) {
+        qDebug() << "[DeviceWindow] Server jar unchanged on device, skipping push";
+        mServerPushSkipped = true;
+        recordStage("push skipped", 0);
+        onSetupStepFinished();
+        return;
+    }
+
+    // Otherwise hash the device's copy: a push is only needed if it differs
+    // (or sha256sum is unavailable, in which case the output won't match)
+    AdbProcess *hashProcess = new AdbProcess(this);
+    connect(hashProcess, &AdbProcess::finished, this,
+            [this, hashProcess, serverLocalPath](int exitCode, QProcess::ExitStatus exitStatus) {
+                const QString output = hashProcess->getOutput();
+                hashProcess->deleteLater();
+
+                if (exitStatus == QProcess::NormalExit && exitCode == 0 && !mServerJarHash.isEmpty()
+                    && output.startsWith(QString::fromLatin1(mServerJarHash))) {
+                    qDebug() << "[DeviceWindow] Server jar on device is identical, skipping push";
+                    ServerJarCache::rememberDeviceHash(mSerial, mServerJarHash);
+                    mServerPushSkipped = true;
+                    recordStage("push skipped (verified)", 0);
+                    onSetupStepFinished();
+                    return;
+                }
+
+                AdbProcess *pushProcess = new AdbProcess(this);
+                connect(pushProcess, &AdbProcess::finished, this, &DeviceWindow::onPushServerFinished);
+                pushProcess->execute(mSerial, {"push", serverLocalPath, SERVER_REMOTE_PATH});
+            });
+    hashProcess->execute(mSerial, {"shell", "sha256sum", SERVER_REMOTE_PATH});
 }
 
 void DeviceWindow::onPushServerFinished(int exitCode, QProcess::ExitStatus exitStatus)
@@ -184,8 +221,11 @@ void DeviceWindow::onPushServerFinished(int exitCode, QProcess::ExitStatus exitS
 
     if (exitStatus == QProcess::NormalExit && exitCode == 0) {
         qDebug() << "[DeviceWindow] Server pushed successfully";
-        ui->label_videoStream->setText(tr("Step 2: Forwarding port..."));
-        forwardPort();
+        if (!mServerJarHash.isEmpty()) {
+            ServerJarCache::rememberDeviceHash(mSerial, mServerJarHash);
+        }
+        recordStage("push", 0);
+        onSetupStepFinished();
     } else {
         showError(tr("Error"),
                   tr("Failed to push scrcpy-server file!\n") + process->getOutput(),
@@ -199,7 +239,8 @@ void DeviceWindow::forwardPort()
     QString forwardRule = QString("tcp:%1").arg(mLocalPort);
     AdbProcess *forwardProcess = new AdbProcess(this);
     connect(forwardProcess, &AdbProcess::finished, this, &DeviceWindow::onForwardPortFinished);
-    forwardProcess->execute(mSerial, {"forward", forwardRule, "localabstract:scrcpy"});
+    forwardProcess->execute(mSerial, {"forward", forwardRule,
+                                      QString("localabstract:%1").arg(mOptions.socketName())});
 }
 
 void DeviceWindow::onForwardPortFinished(int exitCode, QProcess::ExitStatus exitStatus)
@@ -209,15 +250,8 @@ void DeviceWindow::onForwardPortFinished(int exitCode, QProcess::ExitStatus exit
 
     if (exitStatus == QProcess::NormalExit && exitCode == 0) {
         qDebug() << "[DeviceWindow] Port forwarded successfully";
-        ui->label_videoStream->setText(tr("Step 3: Starting server..."));
-        startServer();
-
-        qDebug() << "[DeviceWindow] Step 4: Preparing to connect video socket";
-        ui->label_videoStream->setText(tr("Step 4: Connecting video stream..."));
-        mConnectionRetries = 0;
-
-        // Initial delay before first connection attempt
-        QTimer::singleShot(500, this, &DeviceWindow::connectToSocketWithRetry);
+        recordStage("forward", 0);
+        onSetupStepFinished();
     } else {
         showError(tr("Error"),
                   tr("Port forwarding failed!\n") + process->getOutput(),
@@ -226,6 +260,14 @@ void DeviceWindow::onForwardPortFinished(int exitCode, QProcess::ExitStatus exit
     process->deleteLater();
 }
 
+void DeviceWindow::onSetupStepFinished()
+{
+    if (--mPendingSetupSteps > 0) return;
+
+    ui->widget_videoStream->setText(tr("Step 2: Starting server..."));
+    startServer();
+}
+
 void DeviceWindow::startServer()
 {
     if (mServerProcess) {
@@ -233,22 +275,99 @@ void DeviceWindow::startServer()
     }
 
     mServerProcess = new AdbProcess(this);
+    mServerStartedMs = mBringUpClock.elapsed();
+    mConnectionRetries = 0;
 
-    // OPTIMIZATION: Use QPointer in lambda to prevent accessing deleted object
-    QPointer<DeviceWindow> safeThis(this);
-    connect(mServerProcess.data(), &AdbProcess::finished,
-            [safeThis](int, QProcess::ExitStatus){
+    connect(mServerProcess.data(), &AdbProcess::finished, this,
+            [this](int, QProcess::ExitStatus){
                 qDebug() << "[DeviceWindow] ADB shell process finished";
-                if (safeThis && safeThis->isVisible()) {
-                    safeThis->ui->label_videoStream->setText(safeThis->tr("Connection lost."));
+
+                // A skipped push trusted the index; if the server dies before the
+                // stream starts, the jar may have been removed from the device.
+                if (!mStopping && !mStreaming && mServerPushSkipped && !mStaleJarRetried) {
+                    qWarning() << "[DeviceWindow] Server exited early, pushing the jar again";
+                    mStaleJarRetried = true;
+                    ServerJarCache::forgetDevice(mSerial);
+                    restartServerWithPush();
+                    return;
                 }
+
+                onConnectionLost("server exited");
             });
 
+    // The server logs its first line right before it starts listening, so the
+    // first output is the readiness signal: connect then instead of sleeping.
+    connect(mServerProcess.data(), &AdbProcess::readyReadStandardOutput, this, [this]() {
+        if (!mServerProcess) return;
+        const QByteArray output = mServerProcess->readAllStandardOutput();
+        qDebug().noquote() << "[DeviceWindow] Server:" << output.trimmed();
+        if (mConnectStartedMs < 0) {
+            beginConnecting();
+        }
+    });
+
+    // Fallback in case the server output is delayed or silent
+    mConnectStartedMs = -1;
+    QTimer::singleShot(DisplayConfig::SERVER_READY_FALLBACK_MS, this, [this]() {
+        if (mConnectStartedMs < 0 && mServerProcess) {
+            qDebug() << "[DeviceWindow] No server output yet, connecting anyway";
+            beginConnecting();
+        }
+    });
+
     QStringList args = mOptions.toAdbShellArgs();
     qDebug() << "[DeviceWindow] Starting server with args:" << args.join(" ");
     mServerProcess->execute(mSerial, args);
 }
 
+void DeviceWindow::restartServerWithPush()
+{
+    // Invalidate pending connection retries aimed at the dead server
+    mConnectGeneration++;
+    if (mVideoSocket) {
+        mVideoSocket->disconnect(this);
+        mVideoSocket->abort();
+        mVideoSocket->deleteLater();
+        mVideoSocket.clear();
+    }
+    if (mServerProcess) {
+        mServerProcess->deleteLater();
+        mServerProcess.clear();
+    }
+
+    // The forward is still in place; only the push has to be redone
+    ui->widget_videoStream->setText(tr("Step 1: Pushing server..."));
+    mPendingSetupSteps = 1;
+    pushServer();
+}
+
+void DeviceWindow::beginConnecting()
+{
+    recordStage("server", mServerStartedMs);
+    mConnectStartedMs = mBringUpClock.elapsed();
+
+    qDebug() << "[DeviceWindow] Step 3: Connecting video socket";
+    ui->widget_videoStream->setText(tr("Step 3: Connecting video stream..."));
+    connectToSocketWithRetry();
+}
+
+void DeviceWindow::recordStage(const QString &stage, qint64 startedAtMs)
+{
+    mStageTimings << QString("%1 %2 ms").arg(stage).arg(mBringUpClock.elapsed() - startedAtMs);
+}
+
+void DeviceWindow::reportBringUp(bool success)
+{
+    if (mBringUpReported || !mBringUpClock.isValid()) return;
+    mBringUpReported = true;
+
+    QStringList timings = mStageTimings;
+    timings << QString("total %1 ms").arg(mBringUpClock.elapsed());
+    qInfo() << "[DeviceWindow]" << mSerial << (success ? "bring-up done:" : "bring-up failed:")
+            << timings.join(", ");
+    emit bringUpFinished(mSerial, success, timings.join(", "));
+}
+
 void DeviceWindow::connectToSocketWithRetry()
 {
     if (mConnectionRetries >= DisplayConfig::MAX_CONNECTION_RETRIES) {
@@ -267,14 +386,42 @@ void DeviceWindow::connectToSocketWithRetry()
     // Initialize decoder once
     if (!mDecoder) {
         mDecoder = new VideoDecoderThread(mOptions.video_codec, this);
+        mDecoder->setScaleQuality(mOptions.scale_quality);
+        mDecoder->setProfile(DecoderProfile::fromName(mOptions.decoder_profile));
+        mDecoder->setTargetSize(ui->widget_videoStream->pixelSize(), ui->widget_videoStream->devicePixelRatioF());
 
-        connect(mDecoder.data(), &VideoDecoderThread::frameDecoded,
-                this, &DeviceWindow::onFrameDecoded,
+        if (!mOptions.record_file.isEmpty()) {
+            startRecording();
+        }
+        if (!mOptions.capture_file.isEmpty()) {
+            mCapture = QSharedPointer<StreamCapture>::create(
+                StreamRecorder::reservePath(mOptions.capture_file, mSerial));
+            mDecoder->setCapture(mCapture);
+        }
+
+        // Only a wake-up crosses the event queue; the frame itself is taken
+        // from the decoder's mailbox, so a stalled GUI never builds a backlog
+        connect(mDecoder.data(), &VideoDecoderThread::frameAvailable,
+                this, &DeviceWindow::onFrameAvailable,
                 Qt::QueuedConnection);
 
         connect(mDecoder.data(), &VideoDecoderThread::decodingFinished,
                 this, &DeviceWindow::onDecodingFinished);
 
+        connect(mDecoder.data(), &VideoDecoderThread::socketDisconnected,
+                this, &DeviceWindow::onSocketDisconnected);
+
+        // A fatal error while streaming drops the stream, which is then lost like a
+        // disconnect (and reconnected if enabled); before that the session cannot start
+        connect(mDecoder.data(), &VideoDecoderThread::errorOccurred,
+                this, [this](const QString &error) {
+                    if (mStreaming) {
+                        onConnectionLost(QString("decoder error: %1").arg(error));
+                    } else {
+                        showError(tr("Decoding Error"), error, true);
+                    }
+                });
+
         QPointer<DeviceWindow> safeThis(this);
         connect(mDecoder.data(), &VideoDecoderThread::deviceNameReady,
                 [safeThis](const QString &name){
@@ -290,7 +437,25 @@ void DeviceWindow::connectToSocketWithRetry()
                     }
                 });
 
+        // The decoder lost its references: a fresh key frame beats waiting for the
+        // next natural one. Queued, since the control socket lives in this thread.
+        connect(mDecoder.data(), &VideoDecoderThread::keyFrameRequested,
+                this, [this](){
+                    if (!mControlSender) return;
+
+                    qDebug() << "[DeviceWindow]" << mSerial << "Requesting a key frame";
+                    mControlSender->postResetVideo();
+                });
+
+        mDecoder->setPresentationEnabled(mPresenting, mOptions.hidden_skip_nonref);
         mDecoder->start();
+
+        mSampledDecoded = 0;
+        mSampledPresented = mPresentedFrames;
+        mSampledBytes = 0;
+        mMetricsLatency.reset();
+        mMetricsClock.start();
+        mMetricsTimer->start();
     }
 
     // Create new socket for this attempt
@@ -299,16 +464,16 @@ void DeviceWindow::connectToSocketWithRetry()
 
         optimizeSocketForLowLatency(mVideoSocket.data());
 
+        // A disconnect before the first byte is reported through errorOccurred and retried
         connect(mVideoSocket.data(), &QTcpSocket::connected,
                 this, &DeviceWindow::onSocketConnected);
-        connect(mVideoSocket.data(), &QTcpSocket::disconnected,
-                this, &DeviceWindow::onSocketDisconnected);
         connect(mVideoSocket.data(), &QTcpSocket::readyRead,
                 this, &DeviceWindow::onSocketReadyRead);
 
         // FIXED: Use standard Qt::AutoConnection (default)
+        // 'this' as context so the hand-over to the decoder can drop it with disconnect(this)
         QPointer<DeviceWindow> safeThis(this);
-        connect(mVideoSocket.data(), &QTcpSocket::errorOccurred,
+        connect(mVideoSocket.data(), &QTcpSocket::errorOccurred, this,
                 [safeThis](QAbstractSocket::SocketError error) {
                     if (!safeThis || !safeThis->mVideoSocket) return;
 
@@ -322,9 +487,16 @@ void DeviceWindow::connectToSocketWithRetry()
                     safeThis->mVideoSocket->deleteLater();
                     safeThis->mVideoSocket.clear();
 
-                    // Retry after delay
-                    QTimer::singleShot(DisplayConfig::RETRY_DELAY_MS, safeThis,
-                                       &DeviceWindow::connectToSocketWithRetry);
+                    // Retry with a short exponential backoff: the server is usually
+                    // only milliseconds away from listening when this happens
+                    const int delay = qMin(DisplayConfig::RETRY_DELAY_MS,
+                                           DisplayConfig::INITIAL_RETRY_DELAY_MS << qMin(safeThis->mConnectionRetries, 8));
+                    const int generation = safeThis->mConnectGeneration;
+                    QTimer::singleShot(delay, safeThis, [safeThis, generation]() {
+                        if (safeThis && safeThis->mConnectGeneration == generation) {
+                            safeThis->connectToSocketWithRetry();
+                        }
+                    });
                 });  //Removed Qt::SingleShotConnection
     }
 
@@ -336,10 +508,138 @@ void DeviceWindow::connectToSocketWithRetry()
 void DeviceWindow::onSocketConnected()
 {
     qDebug() << "[DeviceWindow] Video socket connected successfully";
-    ui->label_videoStream->setText(tr("Connection successful, waiting for device metadata..."));
+    ui->widget_videoStream->setText(tr("Connection successful, waiting for device metadata..."));
+}
+
+void DeviceWindow::onSocketReadyRead()
+{
+    if (!mVideoSocket || !mDecoder) return;
+
+    // With a forward tunnel adb accepts the TCP connection even before the
+    // server listens; the first byte (scrcpy's dummy byte) proves the server
+    // is really on the other end. Nothing is consumed here.
+    QTcpSocket *socket = mVideoSocket.data();
+    socket->disconnect(this);
+    mVideoSocket.clear();
     mConnectionRetries = 0;
+    mStreaming = true;
+
+    recordStage("connect", mConnectStartedMs);
+    reportBringUp(true);
+
+    if (mReconnectAttempt > 0) {
+        const qint64 downtime = mDowntimeClock.elapsed();
+        mDowntimeMs += downtime;
+        mReconnectCount++;
+        qInfo() << "[DeviceWindow]" << mSerial << "reconnected after" << mReconnectAttempt << "attempt(s),"
+                << downtime << "ms down:" << mStageTimings.join(", ");
+        mReconnectAttempt = 0;
+
+        // The new stream's timestamps start over, so it goes to a new file
+        if (!mOptions.record_file.isEmpty()) {
+            startRecording();
+        }
+    }
+
+    // From here on the decoder thread reads the socket itself and the GUI
+    // thread is no longer on the video data path. A decoder that already ran
+    // keeps its codec and last frame and resumes at the next key frame.
+    mDecoder->attachSocket(socket, mRecorder);
+
+    // The server accepts its sockets in a fixed order: video, audio, control
+    if (mOptions.audio) {
+        connectAudioSocket();
+    } else {
+        connectControlSocket();
+    }
+}
+
+void DeviceWindow::startRecording()
+{
+    // Packets are remuxed on the host as they arrive, so the file is complete
+    // when the window closes and nothing has to be pulled from the device.
+    // After a reconnect the stream goes to the next segment, never over an earlier one.
+    const QString path = mRecordingPaths.isEmpty()
+        ? StreamRecorder::reservePath(mOptions.record_file, mSerial)
+        : StreamRecorder::reserveSegmentPath(mRecordingPaths.first(), mRecordingPaths.size() + 1);
+    mRecordingPaths.append(path);
+    mRecorder = QSharedPointer<StreamRecorder>(
+        new StreamRecorder(path, mOptions.record_format, true, mOptions.audio),
+        &QObject::deleteLater);
+
+    // Segments closed by a reconnect are only logged: a modal box would stack up
+    // on a flaky link and run the reconnect timers in its nested event loop
+    QPointer<DeviceWindow> safeThis(this);
+    connect(mRecorder.data(), &StreamRecorder::recordingFinished, qApp,
+            [safeThis](const QString &filePath, bool success) {
+                StreamRecorder::releasePath(filePath);
+                if (!safeThis || !safeThis->mStopping) {
+                    if (success) {
+                        qInfo() << "[DeviceWindow] Recording segment saved to" << filePath;
+                    } else {
+                        qWarning() << "[DeviceWindow] Could not write the recording segment" << filePath;
+                    }
+                    return;
+                }
+
+                const QString files = QDir::toNativeSeparators(safeThis->mRecordingPaths.join('\n'));
+                if (success) {
+                    QMessageBox::information(safeThis, tr("Recording Successful"),
+                                             tr("The recording has been saved to:\n%1").arg(files));
+                } else {
+                    QMessageBox::warning(safeThis, tr("Recording Failed"),
+                                         tr("Could not write the recording to:\n%1").arg(QDir::toNativeSeparators(filePath)));
+                }
+            });
+
+    qDebug() << "[DeviceWindow] Recording to" << path;
+    mRecorder->start();
+}
 
-    // Connect control socket
+void DeviceWindow::connectAudioSocket()
+{
+    qDebug() << "[DeviceWindow] Connecting audio socket";
+    if (!mAudioDecoder) {
+        mAudioDecoder = new AudioDecoderThread(mOptions.audio_buffer, this);
+        mAudioDecoder->setCapture(mCapture);
+        connect(mAudioDecoder.data(), &AudioDecoderThread::audioFinished,
+                this, [](const QString &message) {
+                    qDebug() << "[DeviceWindow] Audio:" << message;
+                });
+        connect(mAudioDecoder.data(), &AudioDecoderThread::errorOccurred,
+                this, [](const QString &error) {
+                    qWarning() << "[DeviceWindow] Audio error:" << error;
+                });
+        mAudioDecoder->start();
+    }
+
+    // The server is already listening (the video socket is up), so the
+    // connection is real and needs no retry; control must wait for it though.
+    QTcpSocket *socket = new QTcpSocket(this);
+    optimizeSocketForLowLatency(socket);
+    connect(socket, &QTcpSocket::connected, this, [this, socket]() {
+        socket->disconnect(this);
+        if (mAudioDecoder) {
+            mAudioDecoder->attachSocket(socket, mRecorder);
+        } else {
+            socket->deleteLater();
+        }
+        connectControlSocket();
+    });
+    connect(socket, &QTcpSocket::errorOccurred, this, [this, socket](QAbstractSocket::SocketError) {
+        qWarning() << "[DeviceWindow] Audio socket error:" << socket->errorString();
+        if (mRecorder) {
+            mRecorder->disableStream(StreamRecorder::AudioStream);
+        }
+        socket->disconnect(this);
+        socket->deleteLater();
+        connectControlSocket();
+    });
+    socket->connectToHost("127.0.0.1", mLocalPort);
+}
+
+void DeviceWindow::connectControlSocket()
+{
     qDebug() << "[DeviceWindow] Connecting control socket";
     if (!mControlSender) {
         mControlSender = new ControlSender(this);
@@ -356,30 +656,6 @@ void DeviceWindow::onSocketConnected()
     mControlSender->connectToServer("127.0.0.1", mLocalPort);
 }
 
-void DeviceWindow::onSocketReadyRead()
-{
-    if (!mVideoSocket || !mDecoder) return;
-
-    // OPTIMIZATION: Read ALL available data at once (reduces system calls)
-    qint64 available = mVideoSocket->bytesAvailable();
-    if (available <= 0) return;
-
-    // Read in optimal chunks to reduce overhead
-    static constexpr qint64 MAX_READ_SIZE = 65536; // 64KB chunks
-
-    while (mVideoSocket->bytesAvailable() > 0) {
-        qint64 toRead = qMin(mVideoSocket->bytesAvailable(), MAX_READ_SIZE);
-        QByteArray data = mVideoSocket->read(toRead);
-
-        if (data.isEmpty()) break;
-
-        // Queue data to decoder thread (already thread-safe via Qt::QueuedConnection)
-        QMetaObject::invokeMethod(mDecoder.data(), "decodeData",
-                                  Qt::QueuedConnection,
-                                  Q_ARG(QByteArray, data));
-    }
-}
-
 
 void DeviceWindow::updateCoordinateTransform()
 {
@@ -389,7 +665,7 @@ void DeviceWindow::updateCoordinateTransform()
         return;
     }
 
-    QSize labelSize = ui->label_videoStream->size();
+    QSize labelSize = ui->widget_videoStream->size();
     if (labelSize.isEmpty() || labelSize.width() < 10 || labelSize.height() < 10) {
         mTransform.isValid = false;
         qDebug() << "[DeviceWindow] Transform invalid - label not ready:" << labelSize;
@@ -427,25 +703,38 @@ void DeviceWindow::updateCoordinateTransform()
 
 
 
-void DeviceWindow::onFrameDecoded(const QImage &frame)
+void DeviceWindow::onViewportResized(const QSize &)
 {
-#ifdef QT_DEBUG
-    // FPS counter for performance monitoring
-    mFrameCount++;
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
-    if (now - mLastFpsTime >= 1000) {
-        qDebug() << "[DeviceWindow] FPS:" << mFrameCount;
-        mFrameCount = 0;
-        mLastFpsTime = now;
+    // Mouse mapping depends on where the frame is letterboxed inside the widget
+    updateCoordinateTransform();
+
+    // Have the decoder convert straight to the visible number of device pixels
+    if (mDecoder) {
+        mDecoder->setTargetSize(ui->widget_videoStream->pixelSize(), ui->widget_videoStream->devicePixelRatioF());
     }
-#endif
+}
 
+void DeviceWindow::onFrameAvailable()
+{
+    // With a queueing profile every frame is painted: the next one is taken
+    // once the widget has shown the current one (see onFramePresented())
+    if (!mDecoder || (mDecoder->mailbox().depth() > 1 && ui->widget_videoStream->isFramePending())) {
+        return;
+    }
+
+    DecodedFrame decoded;
+    if (!mDecoder->takeFrame(&decoded)) {
+        return;
+    }
+
+    const QImage &frame = decoded.image;
     if (frame.isNull()) {
         qWarning() << "[DeviceWindow] Received null frame";
         return;
     }
 
-    QSize newFrameSize = frame.size();
+    // The frame may be downscaled to the viewport; input is mapped to the device resolution
+    QSize newFrameSize = decoded.sourceSize;
 
 
     bool resolutionChanged = !newFrameSize.isEmpty() && newFrameSize != mCurrentFrameSize;
@@ -478,7 +767,7 @@ void DeviceWindow::onFrameDecoded(const QImage &frame)
         }
 
 
-        ui->label_videoStream->setFixedSize(windowSize);
+        ui->widget_videoStream->setFixedSize(windowSize);
         adjustSize();
 
 
@@ -487,28 +776,87 @@ void DeviceWindow::onFrameDecoded(const QImage &frame)
             if (!safeThis) return;
 
             // Allow resizing but set minimum size
-            safeThis->ui->label_videoStream->setMinimumSize(windowSize / 2);
-            safeThis->ui->label_videoStream->setMaximumSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
+            safeThis->ui->widget_videoStream->setMinimumSize(windowSize / 2);
+            safeThis->ui->widget_videoStream->setMaximumSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
 
 
             safeThis->updateCoordinateTransform();
 
             qDebug() << "[DeviceWindow] Window setup complete, ready for interaction";
         });
-
-        // Configure scaling on first frame
-        if (mFirstFrame) {
-            ui->label_videoStream->setScaledContents(true);
-            mFirstFrame = false;
-        }
     }
 
+    // A frame replaced before it was painted is not traced, only the one on screen
+    mPendingTiming = decoded.timing;
+    ui->widget_videoStream->setFrame(frame, decoded.dirtyRegion);
+}
+
+void DeviceWindow::onFramePresented()
+{
+    const qint64 presentedUs = LatencyTracker::nowUs();
+    mLatency.record(mPendingTiming, presentedUs);
+    mMetricsLatency.record(mPendingTiming, presentedUs);
+    mPresentedFrames++;
+    mPendingTiming = FrameTiming();
+
+    if (!mLatencyReportClock.isValid()) {
+        mLatencyReportClock.start();
+    } else if (mLatencyReportClock.elapsed() >= DisplayConfig::LATENCY_REPORT_INTERVAL_MS) {
+        qInfo().noquote() << "[DeviceWindow]" << mSerial << "latency" << mLatency.report();
+        mLatency.reset();
+        mLatencyReportClock.restart();
+    }
 
-    ui->label_videoStream->setPixmap(QPixmap::fromImage(frame));
+    if (mDecoder && mDecoder->mailbox().depth() > 1) {
+        onFrameAvailable();
+    }
 }
 
 
 
+void DeviceWindow::sampleMetrics()
+{
+    if (!mDecoder) return;
+
+    const double seconds = qMax<qint64>(1, mMetricsClock.restart()) / 1000.0;
+    const FrameMailbox &mailbox = mDecoder->mailbox();
+    const quint64 decoded = mDecoder->decodedFrames();
+    const quint64 bytes = mDecoder->receivedBytes();
+
+    DeviceMetrics metrics;
+    metrics.serial = mSerial;
+    metrics.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    metrics.fpsIn = (decoded - mSampledDecoded) / seconds;
+    metrics.fpsOut = (mPresentedFrames - mSampledPresented) / seconds;
+    metrics.droppedFrames = mailbox.droppedFrames() + mDecoder->droppedFrames();
+    metrics.staticFrames = mDecoder->staticFrames();
+    metrics.bitrateKbps = (bytes - mSampledBytes) * 8 / seconds / 1000.0;
+    metrics.decodeMs = mMetricsLatency.summary(LatencyTracker::DecodeStage).p50Ms;
+    metrics.queueDepth = mDecoder->framesInFlight();
+    const LatencyTracker::Summary total = mMetricsLatency.summary(LatencyTracker::TotalStage);
+    metrics.latencyP50Ms = total.p50Ms;
+    metrics.latencyP99Ms = total.p99Ms;
+    metrics.presenting = mPresenting;
+    metrics.reconnects = mReconnectCount;
+    metrics.downtimeMs = mDowntimeMs + (mReconnectAttempt > 0 ? mDowntimeClock.elapsed() : 0);
+    if (mAudioDecoder) {
+        const AudioDecoderThread::Stats audio = mAudioDecoder->stats();
+        metrics.audio = true;
+        metrics.audioBufferMs = audio.bufferedMs;
+        metrics.audioTargetMs = audio.targetMs;
+        metrics.audioUnderruns = audio.underruns;
+        metrics.audioDroppedMs = audio.droppedMs;
+        metrics.audioDriftPpm = audio.compensationPpm;
+    }
+
+    mSampledDecoded = decoded;
+    mSampledPresented = mPresentedFrames;
+    mSampledBytes = bytes;
+    mMetricsLatency.reset();
+
+    emit metricsUpdated(metrics);
+}
+
 void DeviceWindow::onDecodingFinished(const QString &message)
 {
     qDebug() << "[DeviceWindow] Decoder:" << message;
@@ -534,14 +882,203 @@ void DeviceWindow::onSocketError(QAbstractSocket::SocketError socketError)
 void DeviceWindow::onSocketDisconnected()
 {
     qDebug() << "[DeviceWindow] Socket disconnected";
-    if (isVisible()) {
-        ui->label_videoStream->setText(tr("Connection lost."));
+
+    // Only the stream in use counts; the decoder still holds the previous one while reconnecting
+    if (mStreaming) {
+        onConnectionLost("video socket disconnected");
+    }
+}
+
+void DeviceWindow::onConnectionLost(const QString &reason)
+{
+    if (mStopping || mReconnectTimer->isActive()) return;
+
+    const bool wasStreaming = mStreaming;
+    mStreaming = false;
+
+    // The first bring-up reports its own failures
+    if (!wasStreaming && mReconnectAttempt == 0) {
+        if (isVisible()) {
+            ui->widget_videoStream->setText(tr("Connection lost."));
+        }
+        return;
+    }
+
+    if (wasStreaming) {
+        qWarning() << "[DeviceWindow]" << mSerial << "Connection lost:" << reason;
+        mDowntimeClock.start();
+    } else {
+        qWarning() << "[DeviceWindow]" << mSerial << "Reconnect attempt" << mReconnectAttempt << "failed:" << reason;
+    }
+
+    if (!mOptions.reconnect) {
+        if (isVisible()) {
+            ui->widget_videoStream->setText(tr("Connection lost."));
+        }
+        return;
+    }
+    scheduleReconnect();
+}
+
+void DeviceWindow::scheduleReconnect()
+{
+    teardownConnection();
+
+    if (mReconnectAttempt >= DisplayConfig::MAX_RECONNECT_ATTEMPTS) {
+        qWarning() << "[DeviceWindow]" << mSerial << "Giving up after" << mReconnectAttempt << "reconnect attempts";
+        mDowntimeMs += mDowntimeClock.elapsed();
+        mReconnectAttempt = 0;
+        ui->widget_videoStream->setText(tr("Connection lost. Could not reconnect after %1 attempts.")
+                                            .arg(DisplayConfig::MAX_RECONNECT_ATTEMPTS));
+        return;
     }
+
+    const int delay = qMin(DisplayConfig::RECONNECT_MAX_DELAY_MS,
+                           DisplayConfig::RECONNECT_INITIAL_DELAY_MS << mReconnectAttempt);
+    mReconnectAttempt++;
+    ui->widget_videoStream->setText(tr("Connection lost, reconnecting (attempt %1 of %2)...")
+                                        .arg(mReconnectAttempt).arg(DisplayConfig::MAX_RECONNECT_ATTEMPTS));
+    mReconnectTimer->start(delay);
+}
+
+void DeviceWindow::teardownConnection()
+{
+    // Pending connection retries and adb callbacks belong to the lost connection
+    mConnectGeneration++;
+    if (mVideoSocket) {
+        mVideoSocket->disconnect(this);
+        mVideoSocket->abort();
+        mVideoSocket->deleteLater();
+        mVideoSocket.clear();
+    }
+    if (mServerProcess) {
+        // Killed without waiting: the GUI thread must not block while the
+        // other sessions keep running. The process goes once it has exited.
+        AdbProcess *process = mServerProcess.data();
+        mServerProcess.clear();
+        process->disconnect(this);
+        if (process->state() == QProcess::NotRunning) {
+            process->deleteLater();
+        } else {
+            connect(process, &AdbProcess::finished, process, &QObject::deleteLater);
+            process->kill();
+        }
+    }
+
+    // The sender is kept and connects again with the new server
+    if (mControlSender) {
+        mControlSender->disconnectFromServer();
+    }
+
+    // Completes the current file; the decoders drop it when the new stream is attached
+    if (mRecorder) {
+        mRecorder->finish();
+        mRecorder.clear();
+    }
+}
+
+void DeviceWindow::reconnect()
+{
+    if (mStopping) return;
+
+    qDebug() << "[DeviceWindow]" << mSerial << "Reconnect attempt" << mReconnectAttempt;
+    mBringUpClock.start();
+    mStageTimings.clear();
+    mStaleJarRetried = false;
+
+    if (mOptions.direct_port != 0) {
+        mServerStartedMs = 0;
+        mConnectionRetries = 0;
+        mConnectStartedMs = -1;
+        beginConnecting();
+        return;
+    }
+
+    // Redo only what is no longer valid: a device still online needs no adb
+    // connect, an existing forward no new one, and a known jar no push
+    const int generation = mConnectGeneration;
+    AdbProcess *stateProcess = new AdbProcess(this);
+    connect(stateProcess, &AdbProcess::finished, this,
+            [this, stateProcess, generation](int exitCode, QProcess::ExitStatus exitStatus) {
+                const bool online = exitStatus == QProcess::NormalExit && exitCode == 0
+                                    && stateProcess->getOutput().trimmed() == "device";
+                stateProcess->deleteLater();
+                if (mStopping || generation != mConnectGeneration) return;
+
+                if (online) {
+                    restoreSetup();
+                    return;
+                }
+                if (!mSerial.contains(':')) {
+                    onConnectionLost("device is not online");
+                    return;
+                }
+
+                // A wireless device: drop adb's stale connection and connect again
+                AdbProcess *disconnectProcess = new AdbProcess(this);
+                connect(disconnectProcess, &AdbProcess::finished, this, [this, disconnectProcess, generation]() {
+                    disconnectProcess->deleteLater();
+                    if (mStopping || generation != mConnectGeneration) return;
+
+                    AdbProcess *connectProcess = new AdbProcess(this);
+                    connect(connectProcess, &AdbProcess::finished, this,
+                            [this, connectProcess, generation](int exitCode, QProcess::ExitStatus) {
+                                const QString output = connectProcess->getOutput();
+                                connectProcess->deleteLater();
+                                if (mStopping || generation != mConnectGeneration) return;
+
+                                if (exitCode == 0 && output.contains("connected to")) {
+                                    recordStage("adb connect", 0);
+                                    restoreSetup();
+                                } else {
+                                    onConnectionLost("adb connect failed: " + output.trimmed());
+                                }
+                            });
+                    connectProcess->execute("", {"connect", mSerial});
+                });
+                disconnectProcess->execute("", {"disconnect", mSerial});
+            });
+    stateProcess->execute(mSerial, {"get-state"});
+}
+
+void DeviceWindow::restoreSetup()
+{
+    ui->widget_videoStream->setText(tr("Reconnecting: restoring the server..."));
+    mPendingSetupSteps = 2;
+    pushServer();
+
+    const int generation = mConnectGeneration;
+    AdbProcess *listProcess = new AdbProcess(this);
+    connect(listProcess, &AdbProcess::finished, this,
+            [this, listProcess, generation](int exitCode, QProcess::ExitStatus exitStatus) {
+                const QString rule = QString("%1 tcp:%2 localabstract:%3")
+                                         .arg(mSerial).arg(mLocalPort).arg(mOptions.socketName());
+                const bool forwarded = exitStatus == QProcess::NormalExit && exitCode == 0
+                                       && listProcess->getOutput().contains(rule);
+                listProcess->deleteLater();
+                if (mStopping || generation != mConnectGeneration) return;
+
+                if (forwarded) {
+                    recordStage("forward kept", 0);
+                    onSetupStepFinished();
+                } else {
+                    forwardPort();
+                }
+            });
+    listProcess->execute("", {"forward", "--list"});
 }
 
 void DeviceWindow::stopAll()
 {
     qDebug() << "[DeviceWindow] Stopping all services for" << mSerial;
+    mStopping = true;
+
+    if (mMetricsTimer) {
+        mMetricsTimer->stop();
+    }
+    if (mReconnectTimer) {
+        mReconnectTimer->stop();
+    }
 
     // Stop decoder thread (non-blocking)
     if (mDecoder) {
@@ -566,7 +1103,39 @@ void DeviceWindow::stopAll()
         mDecoder.clear();
     }
 
-    // Close video socket
+    if (mAudioDecoder) {
+        mAudioDecoder->stop();
+        mAudioDecoder->quit();
+
+        QPointer<AudioDecoderThread> audioDecoder = mAudioDecoder;
+        QTimer::singleShot(0, [audioDecoder]() {
+            if (!audioDecoder) return;
+
+            if (!audioDecoder->wait(DisplayConfig::DECODER_STOP_TIMEOUT_MS)) {
+                qWarning() << "[DeviceWindow] Audio decoder timeout, terminating";
+                audioDecoder->terminate();
+                audioDecoder->wait(1000);
+            }
+            audioDecoder->deleteLater();
+        });
+
+        mAudioDecoder.clear();
+    }
+
+    // The decoders drop their references when they are deleted; the file is
+    // completed in the background and the last reference deletes the recorder
+    if (mRecorder) {
+        mRecorder->finish();
+        mRecorder.clear();
+    }
+
+    // The file is closed once the decoders release it
+    if (mCapture) {
+        StreamRecorder::releasePath(mCapture->filePath());
+        mCapture.clear();
+    }
+
+    // Close video socket (only set while connecting; the decoder owns it afterwards)
     if (mVideoSocket) {
         mVideoSocket->close();
         mVideoSocket->deleteLater();
@@ -590,12 +1159,20 @@ void DeviceWindow::stopAll()
         mControlSender.clear();
     }
 
-    // Remove port forwarding
-    AdbProcess *removeForwardProcess = new AdbProcess();
-    connect(removeForwardProcess, &AdbProcess::finished,
-            removeForwardProcess, &QObject::deleteLater);
-    removeForwardProcess->execute(mSerial, {"forward", "--remove",
-                                            QString("tcp:%1").arg(mLocalPort)});
+    // Remove port forwarding and return the port to the pool (once: stopAll()
+    // runs from both closeEvent() and the destructor)
+    if (mLocalPort != 0) {
+        if (mOptions.direct_port == 0) {
+            AdbProcess *removeForwardProcess = new AdbProcess();
+            connect(removeForwardProcess, &AdbProcess::finished,
+                    removeForwardProcess, &QObject::deleteLater);
+            removeForwardProcess->execute(mSerial, {"forward", "--remove",
+                                                    QString("tcp:%1").arg(mLocalPort)});
+
+            PortAllocator::instance().release(mLocalPort);
+        }
+        mLocalPort = 0;
+    }
 }
 
 QPoint DeviceWindow::mapMousePosition(const QPoint &pos)
@@ -637,7 +1214,7 @@ void DeviceWindow::mousePressEvent(QMouseEvent *event)
     if (!mControlSender || event->button() != Qt::LeftButton) {
         return;
     }
-    QPoint labelPos = ui->label_videoStream->mapFromGlobal(event->globalPos());
+    QPoint labelPos = ui->widget_videoStream->mapFromGlobal(event->globalPos());
     QPoint devicePos = mapMousePosition(labelPos);
     if (!devicePos.isNull()) {
         qDebug() << "[DeviceWindow] Mouse press:"
@@ -659,7 +1236,7 @@ void DeviceWindow::mouseReleaseEvent(QMouseEvent *event)
     if (!mControlSender || event->button() != Qt::LeftButton) {
         return;
     }
-    QPoint labelPos = ui->label_videoStream->mapFromGlobal(event->globalPos());
+    QPoint labelPos = ui->widget_videoStream->mapFromGlobal(event->globalPos());
     QPoint devicePos = mapMousePosition(labelPos);
     if (!devicePos.isNull()) {
         qDebug() << "[DeviceWindow] Mouse release at device coords:" << devicePos;
@@ -674,7 +1251,7 @@ void DeviceWindow::mouseMoveEvent(QMouseEvent *event)
     if (!mControlSender || !mIsMousePressed) {
         return;
     }
-    QPoint labelPos = ui->label_videoStream->mapFromGlobal(event->globalPos());
+    QPoint labelPos = ui->widget_videoStream->mapFromGlobal(event->globalPos());
     QPoint devicePos = mapMousePosition(labelPos);
     if (!devicePos.isNull()) {
         mControlSender->postInjectTouch(AMOTION_EVENT_ACTION_MOVE, devicePos, mCurrentFrameSize);
@@ -686,6 +1263,65 @@ void DeviceWindow::resizeEvent(QResizeEvent *event)
     QMainWindow::resizeEvent(event);
 }
 
+void DeviceWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+
+    // Exposure (minimized, or occluded where the platform reports it) changes on the native window
+    if (windowHandle()) {
+        windowHandle()->installEventFilter(this);
+    }
+    updatePresentation();
+}
+
+void DeviceWindow::hideEvent(QHideEvent *event)
+{
+    QMainWindow::hideEvent(event);
+    updatePresentation();
+}
+
+void DeviceWindow::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) {
+        updatePresentation();
+    }
+}
+
+bool DeviceWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Expose && watched == windowHandle()) {
+        updatePresentation();
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void DeviceWindow::updatePresentation()
+{
+    const bool presenting = isVisible() && !isMinimized()
+        && (!windowHandle() || windowHandle()->isExposed());
+    if (presenting == mPresenting) {
+        return;
+    }
+    mPresenting = presenting;
+    qDebug() << "[DeviceWindow]" << mSerial << (presenting ? "visible, presenting frames" : "hidden, decode-only");
+
+    // Frames shown before the switch must not be traced as if they were new
+    mPendingTiming = FrameTiming();
+    if (!mDecoder) {
+        return;
+    }
+
+    mDecoder->setPresentationEnabled(presenting, mOptions.hidden_skip_nonref);
+    if (presenting) {
+        // A static screen sends no new frames, so show the latest decoded one now
+        const QImage frame = mDecoder->grabViewportFrame();
+        if (!frame.isNull()) {
+            ui->widget_videoStream->setFrame(frame);
+        }
+    }
+}
+
 
 void DeviceWindow::keyPressEvent(QKeyEvent *event)
 {
@@ -787,9 +1423,10 @@ void DeviceWindow::on_action_collapseNotifications_triggered()
 
 void DeviceWindow::on_action_screenshot_triggered()
 {
-    if (mCurrentFrameSize.isEmpty()) return;
+    if (mCurrentFrameSize.isEmpty() || !mDecoder) return;
 
-    QPixmap screenshot = ui->label_videoStream->pixmap(Qt::ReturnByValue);
+    // Displayed frames are scaled to the window; grab the full decoded resolution instead
+    QImage screenshot = mDecoder->grabFullResolutionFrame();
     if (screenshot.isNull()) return;
 
     QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
@@ -4,9 +4,13 @@
 #include <QMainWindow>
 #include <QTcpSocket>
 #include <QPointer>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 #include "adbprocess.h"
 #include "scrcpyoptions.h"
 #include "controlsender.h"
+#include "latencytracker.h"
+#include "metricsexporter.h"
 #include <QKeyEvent>
 
 QT_BEGIN_NAMESPACE
@@ -14,6 +18,10 @@ namespace Ui { class DeviceWindow; }
 QT_END_NAMESPACE
 
 class VideoDecoderThread;
+class AudioDecoderThread;
+class StreamCapture;
+class StreamRecorder;
+class QTimer;
 
 /**
  * @class DeviceWindow
@@ -21,15 +29,18 @@ class VideoDecoderThread;
  *
  * This class orchestrates the entire process for a device connection:
  * 1. Pushing the scrcpy server to the device.
- * 2. Setting up a reverse TCP port forward.
- * 3. Starting the server on the device.
- * 4. Establishing video and control socket connections.
- * 5. Decoding the video stream and displaying it with optimized rendering.
+ * 2. Setting up a TCP port forward (concurrently with step 1).
+ * 3. Starting the server on the device and connecting as soon as it reports readiness.
+ * 4. Establishing the video, audio and control socket connections (in the server's order).
+ * 5. Handing the video and audio sockets to their decoder threads, which read, decode and play them.
  * 6. Forwarding user input (mouse, keyboard) to the device.
  * 7. Handling cleanup and teardown of all resources.
  *
+ * With ScrcpyOptions::reconnect, a lost connection is re-established in the
+ * same window with a backoff, redoing only the steps that are no longer valid.
+ *
  * OPTIMIZATIONS:
- * - Uses QLabel's built-in scaling instead of manual per-frame scaling
+ * - The decoder converts frames straight to the visible size; VideoWidget paints them
  * - Caches coordinate transformations for mouse events
  * - Defers window resizing to prevent blocking
  * - Thread-safe UI updates with Qt::QueuedConnection
@@ -44,10 +55,29 @@ public:
 
     QString getSerial() const;
 
+public slots:
+    /**
+     * @brief Starts the connection bring-up. Invoked by the SessionScheduler when a slot is free.
+     */
+    void startStreaming();
+
 signals:
     void windowClosed(const QString &serial);
     void statusUpdated(const QString &serial, const QString &deviceName, const QSize &frameSize);
 
+    /**
+     * @brief Emitted once per bring-up, when the video stream starts or the attempt fails.
+     * @param serial The device serial.
+     * @param success True if the video stream is flowing.
+     * @param stageTimings Human-readable per-stage durations, e.g. "push 812 ms, forward 40 ms, ...".
+     */
+    void bringUpFinished(const QString &serial, bool success, const QString &stageTimings);
+
+    /**
+     * @brief Emitted every DisplayConfig::METRICS_INTERVAL_MS while the video stream is running.
+     */
+    void metricsUpdated(const DeviceMetrics &metrics);
+
 protected:
     void closeEvent(QCloseEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
@@ -56,11 +86,14 @@ protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
     void keyReleaseEvent(QKeyEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 
 private slots:
     // Connection workflow
-    void startStreaming();
     void pushServer();
     void onPushServerFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void forwardPort();
@@ -73,7 +106,10 @@ private slots:
     void onSocketDisconnected();
     void onSocketError(QAbstractSocket::SocketError socketError);
     void onSocketReadyRead();
-    void onFrameDecoded(const QImage &frame);
+    void onFrameAvailable();
+    void onViewportResized(const QSize &size);
+    void onFramePresented();
+    void sampleMetrics();
     void onDecodingFinished(const QString &message);
 
     // Toolbar actions
@@ -94,11 +130,20 @@ private:
         static constexpr int BASE_HEIGHT_PORTRAIT = 800;
         static constexpr int BASE_WIDTH_LANDSCAPE = 960;
         static constexpr int MAX_CONNECTION_RETRIES = 20;
+        static constexpr int INITIAL_RETRY_DELAY_MS = 25;
         static constexpr int RETRY_DELAY_MS = 200;
+        static constexpr int SERVER_READY_FALLBACK_MS = 300;
         static constexpr int DECODER_STOP_TIMEOUT_MS = 2000;
         static constexpr int SERVER_PROCESS_TIMEOUT_MS = 1000;
+        static constexpr int LATENCY_REPORT_INTERVAL_MS = 10000;
+        static constexpr int METRICS_INTERVAL_MS = 1000;
+        static constexpr int RECONNECT_INITIAL_DELAY_MS = 500;
+        static constexpr int RECONNECT_MAX_DELAY_MS = 8000;
+        static constexpr int MAX_RECONNECT_ATTEMPTS = 10;
     };
 
+    static constexpr const char *SERVER_REMOTE_PATH = "/data/local/tmp/scrcpy-server.jar";
+
     /**
      * @struct CoordinateTransform
      * @brief Caches mouse coordinate transformation calculations
@@ -117,8 +162,25 @@ private:
 
     void stopAll();
     void setupToolbarActions();
+
+    // Bring-up helpers
+    void onSetupStepFinished();
+    void beginConnecting();
+    void connectAudioSocket();
+    void connectControlSocket();
+    void restartServerWithPush();
+    void recordStage(const QString &stage, qint64 startedAtMs);
+    void reportBringUp(bool success);
+
     void showError(const QString &title, const QString &message, bool fatal = false);
 
+    // Session resumption (ScrcpyOptions::reconnect)
+    void onConnectionLost(const QString &reason);
+    void scheduleReconnect();
+    void teardownConnection();
+    void reconnect();
+    void restoreSetup();
+
     // Optimized coordinate mapping
     QPoint mapMousePosition(const QPoint &pos);
     void updateCoordinateTransform();
@@ -128,14 +190,19 @@ private:
     int qtModifiersToAndroidMetaState(Qt::KeyboardModifiers modifiers);
 
     void optimizeSocketForLowLatency(QTcpSocket* socket);
+    void startRecording();
 
     // UI and core members
     Ui::DeviceWindow *ui;
     QString mSerial;
-    quint16 mLocalPort;
+    quint16 mLocalPort;                   // Leased from PortAllocator, 0 once released
     QPointer<AdbProcess> mServerProcess;  // Changed to QPointer for safety
     QPointer<QTcpSocket> mVideoSocket;    // Changed to QPointer for safety
     QPointer<VideoDecoderThread> mDecoder; // Changed to QPointer for safety
+    QPointer<AudioDecoderThread> mAudioDecoder;
+    QSharedPointer<StreamRecorder> mRecorder; // Shared with the decoders while recording
+    QStringList mRecordingPaths;              // One file per stream, i.e. per reconnect
+    QSharedPointer<StreamCapture> mCapture;   // Shared with the decoders while capturing
     QString mDeviceName;
 
     // Control and state
@@ -145,16 +212,51 @@ private:
     QSize mCurrentFrameSize;
     bool mIsMousePressed = false;
 
+    // Bring-up state and per-stage timings
+    QElapsedTimer mBringUpClock;
+    QStringList mStageTimings;
+    int mPendingSetupSteps = 0;
+    qint64 mServerStartedMs = 0;
+    qint64 mConnectStartedMs = -1;
+    bool mBringUpReported = false;
+    int mConnectGeneration = 0;     // Bumped to cancel pending connection retries
+    bool mStopping = false;
+    bool mStreaming = false;        // Video data is flowing on the current connection
+
+    // Server jar deployment (see ServerJarCache)
+    QByteArray mServerJarHash;
+    bool mServerPushSkipped = false;
+    bool mStaleJarRetried = false;
+
+    // Reconnect state: the window, decoders and control sender outlive the connection
+    QTimer *mReconnectTimer = nullptr;
+    int mReconnectAttempt = 0;      // 0 while connected
+    int mReconnectCount = 0;
+    qint64 mDowntimeMs = 0;
+    QElapsedTimer mDowntimeClock;
+
     // Performance optimizations
     CoordinateTransform mTransform;
-    bool mFirstFrame = true; // Track first frame to set scaling mode once
 
+    // Latency tracing: timing of the frame last handed to the video widget
+    LatencyTracker mLatency;
+    FrameTiming mPendingTiming;
+    QElapsedTimer mLatencyReportClock;
+
+    /**
+     * @brief Switches the decoder to decode-only while the window is minimized, hidden or occluded.
+     */
+    void updatePresentation();
+    bool mPresenting = true;
 
-    // FPS monitoring (debug builds only)
-#ifdef QT_DEBUG
-    qint64 mFrameCount = 0;
-    qint64 mLastFpsTime = 0;
-#endif
+    // Live metrics: counters at the previous sample, to turn totals into rates
+    QTimer *mMetricsTimer = nullptr;
+    LatencyTracker mMetricsLatency;
+    QElapsedTimer mMetricsClock;
+    quint64 mPresentedFrames = 0;
+    quint64 mSampledDecoded = 0;
+    quint64 mSampledPresented = 0;
+    quint64 mSampledBytes = 0;
 };
 
 #endif // DEVICEWINDOW_H
@@ -0,0 +1,126 @@
+#include "framechangedetector.h"
+#include <QVector>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+FrameChangeDetector::~FrameChangeDetector()
+{
+    av_frame_free(&m_reference);
+}
+
+void FrameChangeDetector::setReference(const AVFrame *frame)
+{
+    if (!m_reference) {
+        m_reference = av_frame_alloc();
+        if (!m_reference) {
+            return;
+        }
+    }
+    av_frame_unref(m_reference);
+    if (av_frame_ref(m_reference, frame) < 0) {
+        av_frame_unref(m_reference);
+    }
+}
+
+void FrameChangeDetector::reset()
+{
+    if (m_reference) {
+        av_frame_unref(m_reference);
+    }
+}
+
+QRegion FrameChangeDetector::changedRegion(const AVFrame *frame) const
+{
+    const QRect whole(0, 0, frame->width, frame->height);
+    const AVFrame *reference = m_reference;
+    if (!reference || !reference->buf[0]
+        || reference->width != frame->width || reference->height != frame->height
+        || reference->format != frame->format) {
+        return whole;
+    }
+
+    // Only plain CPU-side pixel data can be compared
+    const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        return whole;
+    }
+
+    // Changed luma columns [left, right) per band of rows; left > right if unchanged
+    const int bandCount = (frame->height + BAND_ROWS - 1) / BAND_ROWS;
+    QVector<int> left(bandCount, frame->width);
+    QVector<int> right(bandCount, 0);
+
+    const int planes = av_pix_fmt_count_planes(format);
+    for (int plane = 0; plane < planes; ++plane) {
+        // Planes 1 and 2 hold chroma (interleaved in plane 1 for nv12/p010)
+        const int shiftY = (plane == 1 || plane == 2) ? desc->log2_chroma_h : 0;
+        const int rows = AV_CEIL_RSHIFT(frame->height, shiftY);
+        const int rowBytes = av_image_get_linesize(format, frame->width, plane);
+        if (rowBytes <= 0) {
+            return whole;
+        }
+
+        for (int row = 0; row < rows; ++row) {
+            const uint8_t *current = frame->data[plane] + static_cast<ptrdiff_t>(row) * frame->linesize[plane];
+            const uint8_t *previous = reference->data[plane] + static_cast<ptrdiff_t>(row) * reference->linesize[plane];
+            if (memcmp(current, previous, static_cast<size_t>(rowBytes)) == 0) {
+                continue;
+            }
+
+            // Narrow the row down to the chunks that differ at either end
+            int first = 0;
+            while (first + CHUNK_BYTES < rowBytes && memcmp(current + first, previous + first, CHUNK_BYTES) == 0) {
+                first += CHUNK_BYTES;
+            }
+            int end = rowBytes;
+            int last = (rowBytes - 1) / CHUNK_BYTES * CHUNK_BYTES;
+            while (last > first && memcmp(current + last, previous + last, static_cast<size_t>(end - last)) == 0) {
+                end = last;
+                last -= CHUNK_BYTES;
+            }
+
+            // Bytes to luma columns, rounded outwards: one row spans the frame's width
+            const int x0 = static_cast<int>(qint64(first) * frame->width / rowBytes);
+            const int x1 = static_cast<int>((qint64(end) * frame->width + rowBytes - 1) / rowBytes);
+            const int y0 = row << shiftY;
+            const int y1 = qMin(frame->height, (row + 1) << shiftY);
+            for (int band = y0 / BAND_ROWS; band <= (y1 - 1) / BAND_ROWS; ++band) {
+                left[band] = qMin(left[band], x0);
+                right[band] = qMax(right[band], x1);
+            }
+        }
+    }
+
+    // Adjacent changed bands become one rectangle
+    QVector<QRect> rects;
+    for (int band = 0; band < bandCount; ++band) {
+        if (left[band] >= right[band]) {
+            continue;
+        }
+        const QRect rect = QRect(left[band], band * BAND_ROWS, right[band] - left[band], BAND_ROWS) & whole;
+        if (!rects.isEmpty() && rects.last().bottom() + 1 == rect.top()) {
+            rects.last() = rects.last().united(rect);
+        } else {
+            rects.append(rect);
+        }
+    }
+
+    QRegion region;
+    if (rects.size() > MAX_RECTS) {
+        QRect bounds;
+        for (const QRect &rect : std::as_const(rects)) {
+            bounds = bounds.united(rect);
+        }
+        return bounds;
+    }
+    for (const QRect &rect : std::as_const(rects)) {
+        region += rect;
+    }
+    return region;
+}
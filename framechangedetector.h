@@ -0,0 +1,64 @@
+#ifndef FRAMECHANGEDETECTOR_H
+#define FRAMECHANGEDETECTOR_H
+
+#include <QRegion>
+
+struct AVFrame;
+
+/**
+ * @file framechangedetector.h
+ * @brief Defines the FrameChangeDetector class, which finds the area a decoded frame changed.
+ */
+
+/**
+ * @class FrameChangeDetector
+ * @brief Compares decoded frames with the last presented one, to skip static frames and repaint only what changed.
+ *
+ * Android screens are static most of the time, yet the encoder keeps sending
+ * frames (repeats of the last one, or a blinking cursor). The detector holds
+ * a reference to the frame last converted for display; libavcodec never
+ * writes to a frame once it is output, so it can be compared with the next
+ * one directly, with no hashing and no false matches.
+ *
+ * Every plane is compared row by row with memcmp (vectorized by the C
+ * library). Rows that differ are narrowed down to CHUNK_BYTES columns from
+ * each end, and the result is gathered per band of BAND_ROWS luma rows, so
+ * a clock or a cursor costs a few small rectangles, not the whole frame.
+ *
+ * Used by the decoder thread only; not thread-safe.
+ */
+class FrameChangeDetector
+{
+public:
+    FrameChangeDetector() = default;
+    ~FrameChangeDetector();
+
+    /**
+     * @brief Returns the area of @p frame that differs from the reference, in frame pixels.
+     * @return An empty region if nothing changed; the whole frame if there is no
+     *         reference or the size or pixel format differs.
+     */
+    QRegion changedRegion(const AVFrame *frame) const;
+
+    /**
+     * @brief Makes @p frame the reference, i.e. what is on screen now. Keeps a reference, not a copy.
+     */
+    void setReference(const AVFrame *frame);
+
+    /**
+     * @brief Drops the reference, so the next frame counts as changed everywhere.
+     */
+    void reset();
+
+private:
+    Q_DISABLE_COPY(FrameChangeDetector)
+
+    static constexpr int BAND_ROWS = 16;
+    static constexpr int CHUNK_BYTES = 64;
+    // Beyond this many rectangles their bounding rectangle is cheaper to repaint
+    static constexpr int MAX_RECTS = 16;
+
+    AVFrame *m_reference = nullptr;
+};
+
+#endif // FRAMECHANGEDETECTOR_H
@@ -0,0 +1,84 @@
+#include "framemailbox.h"
+#include <QMutexLocker>
+#include <utility>
+
+namespace {
+
+// What a dropped frame changed still has to be repainted with the next one
+void carryDirtyRegion(const DecodedFrame &dropped, DecodedFrame *next)
+{
+    if (dropped.dirtyRegion.isEmpty() || next->dirtyRegion.isEmpty()
+        || dropped.image.size() != next->image.size()) {
+        next->dirtyRegion = QRegion();
+    } else {
+        next->dirtyRegion += dropped.dirtyRegion;
+    }
+}
+
+} // namespace
+
+void FrameMailbox::setDepth(int depth)
+{
+    // Frames beyond the new depth are released outside the lock
+    QList<DecodedFrame> excess;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_depth = qBound(1, depth, MAX_DEPTH);
+        while (m_frames.size() > m_depth) {
+            excess.append(m_frames.takeFirst());
+            carryDirtyRegion(excess.last(), &m_frames.first());
+        }
+    }
+}
+
+int FrameMailbox::depth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_depth;
+}
+
+bool FrameMailbox::post(DecodedFrame &&frame)
+{
+    m_produced.fetchAndAddRelaxed(1);
+
+    // The replaced frame is released outside the lock
+    DecodedFrame replaced;
+    bool wasEmpty;
+    bool wasFull;
+    {
+        QMutexLocker locker(&m_mutex);
+        wasEmpty = m_frames.isEmpty();
+        wasFull = m_frames.size() >= m_depth;
+        if (wasFull) {
+            replaced = m_frames.takeFirst();
+            carryDirtyRegion(replaced, m_frames.isEmpty() ? &frame : &m_frames.first());
+        }
+        m_frames.append(std::move(frame));
+    }
+
+    if (wasFull) {
+        m_dropped.fetchAndAddRelaxed(1);
+    }
+    return wasEmpty;
+}
+
+bool FrameMailbox::take(DecodedFrame *frame)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_frames.isEmpty()) {
+            return false;
+        }
+        *frame = m_frames.takeFirst();
+    }
+
+    m_presented.fetchAndAddRelaxed(1);
+    return true;
+}
+
+void FrameMailbox::clear()
+{
+    QList<DecodedFrame> discarded;
+    QMutexLocker locker(&m_mutex);
+    discarded.swap(m_frames);
+}
@@ -0,0 +1,91 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QMutex>
+#include <QRegion>
+#include <QAtomicInteger>
+#include "latencytracker.h"
+
+/**
+ * @file framemailbox.h
+ * @brief Defines DecodedFrame and the FrameMailbox used to hand frames from the decoder to the GUI.
+ */
+
+/**
+ * @struct DecodedFrame
+ * @brief A converted frame ready for display.
+ */
+struct DecodedFrame
+{
+    QImage image;           // Scaled to the viewport, backed by a FramePool buffer
+    QSize sourceSize;       // Decoded (device) resolution
+    QRegion dirtyRegion;    // What changed since the previous frame, in image pixels; empty for everything
+    qint64 pts = -1;        // Presentation timestamp in microseconds (device clock), -1 if unknown
+    FrameTiming timing;     // Host-side pipeline timestamps
+};
+
+/**
+ * @class FrameMailbox
+ * @brief Bounded, by default single-slot, latest-frame-wins handoff between a producer and a consumer thread.
+ *
+ * Queuing every frame through the event loop lets a stalled GUI build up an
+ * unbounded backlog, and the mirror stays behind by that amount afterwards.
+ * The mailbox holds at most depth() frames: when it is full, a new frame
+ * replaces the oldest one not taken yet (counted as dropped), so latency
+ * stays bounded no matter how long the GUI stalls. With the default depth
+ * of one the consumer always displays the newest frame; a deeper mailbox
+ * trades that many frames of delay for showing every frame through short
+ * GUI hiccups (see DecoderProfile). A replaced frame's dirty region is
+ * carried over to the frame shown instead, so partial repaints stay correct.
+ *
+ * Notification is edge-triggered: post() reports true only when the mailbox
+ * goes from empty to non-empty, so the producer wakes the consumer at most
+ * once until it is drained; a consumer of a deeper mailbox keeps calling
+ * take() until it returns false.
+ */
+class FrameMailbox
+{
+public:
+    /**
+     * @brief Sets how many frames are held before the oldest is replaced (1 to MAX_DEPTH).
+     */
+    void setDepth(int depth);
+    int depth() const;
+
+    /**
+     * @brief Stores a frame, replacing the oldest frame not taken yet if the mailbox is full. Called by the producer.
+     * @return True if the consumer must be notified (the mailbox was empty).
+     */
+    bool post(DecodedFrame &&frame);
+
+    /**
+     * @brief Takes the oldest frame held, the latest one with a depth of one. Called by the consumer.
+     * @return False if the mailbox is empty.
+     */
+    bool take(DecodedFrame *frame);
+
+    /**
+     * @brief Drops the pending frames, if any, e.g. so their buffers return to the pool.
+     */
+    void clear();
+
+    quint64 producedFrames() const { return m_produced.loadRelaxed(); }
+    quint64 presentedFrames() const { return m_presented.loadRelaxed(); }
+    quint64 droppedFrames() const { return m_dropped.loadRelaxed(); }
+
+    static constexpr int MAX_DEPTH = 8;
+
+private:
+    mutable QMutex m_mutex;
+    QList<DecodedFrame> m_frames;
+    int m_depth = 1;
+
+    QAtomicInteger<quint64> m_produced{0};
+    QAtomicInteger<quint64> m_presented{0};
+    QAtomicInteger<quint64> m_dropped{0};
+};
+
+#endif // FRAMEMAILBOX_H
@@ -0,0 +1,141 @@
+#include "framepool.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+constexpr int ROW_ALIGNMENT = 64;
+
+inline qsizetype alignedBytesPerLine(int width)
+{
+    return (static_cast<qsizetype>(width) * 4 + ROW_ALIGNMENT - 1) & ~qsizetype(ROW_ALIGNMENT - 1);
+}
+
+} // namespace
+
+struct FramePool::Shared
+{
+    struct Slot {
+        Shared *owner = nullptr;
+        uchar *data = nullptr;
+        qsizetype bytes = 0;
+    };
+
+    QMutex mutex;
+    QVector<Slot*> allSlots;
+    QVector<Slot*> freeSlots;
+    QAtomicInt refs{1};   // The pool itself plus one per outstanding image
+
+    void unref()
+    {
+        if (!refs.deref()) {
+            for (Slot *slot : std::as_const(allSlots)) {
+                qFreeAligned(slot->data);
+                delete slot;
+            }
+            delete this;
+        }
+    }
+
+    // QImageCleanupFunction: runs on the thread that drops the last image copy
+    static void release(void *info)
+    {
+        Slot *slot = static_cast<Slot*>(info);
+        Shared *shared = slot->owner;
+        {
+            QMutexLocker locker(&shared->mutex);
+            shared->freeSlots.append(slot);
+        }
+        shared->unref();
+    }
+};
+
+FramePool::FramePool(int capacity, ExhaustionPolicy policy)
+    : m_shared(new Shared), m_policy(policy), m_dropped(0)
+{
+    // Slots are created up front; their buffers are sized by the first acquire()
+    const int slotCount = qBound(1, capacity, MAX_SLOTS);
+    for (int i = 0; i < slotCount; ++i) {
+        auto *slot = new Shared::Slot;
+        slot->owner = m_shared;
+        m_shared->allSlots.append(slot);
+        m_shared->freeSlots.append(slot);
+    }
+}
+
+FramePool::~FramePool()
+{
+    // Buffers still held by images are freed when the last one is released
+    m_shared->unref();
+}
+
+QImage FramePool::acquire(const QSize &size)
+{
+    if (size.isEmpty()) {
+        return QImage();
+    }
+
+    const qsizetype bytesPerLine = alignedBytesPerLine(size.width());
+    const qsizetype bytes = bytesPerLine * size.height();
+
+    Shared::Slot *slot = nullptr;
+    {
+        QMutexLocker locker(&m_shared->mutex);
+        if (!m_shared->freeSlots.isEmpty()) {
+            slot = m_shared->freeSlots.takeLast();
+        } else if (m_policy == ExhaustionPolicy::Grow && m_shared->allSlots.size() < MAX_SLOTS) {
+            slot = new Shared::Slot;
+            slot->owner = m_shared;
+            m_shared->allSlots.append(slot);
+            qDebug() << "[FramePool] Consumer is behind, grew to" << m_shared->allSlots.size() << "slots";
+        }
+    }
+
+    if (!slot) {
+        m_dropped.fetchAndAddRelaxed(1);
+        return QImage();
+    }
+
+    // Reallocate only if the buffer is too small, or far too large after a shrink
+    if (slot->bytes < bytes || slot->bytes > bytes * 4) {
+        qFreeAligned(slot->data);
+        slot->data = static_cast<uchar*>(qMallocAligned(static_cast<size_t>(bytes), ROW_ALIGNMENT));
+        slot->bytes = slot->data ? bytes : 0;
+        if (!slot->data) {
+            QMutexLocker locker(&m_shared->mutex);
+            m_shared->freeSlots.append(slot);
+            return QImage();
+        }
+    }
+
+    m_shared->refs.ref();
+    return QImage(slot->data, size.width(), size.height(), static_cast<int>(bytesPerLine),
+                  QImage::Format_RGB32, &Shared::release, slot);
+}
+
+void FramePool::reserve(int capacity)
+{
+    QMutexLocker locker(&m_shared->mutex);
+    while (m_shared->allSlots.size() < qMin(capacity, MAX_SLOTS)) {
+        auto *slot = new Shared::Slot;
+        slot->owner = m_shared;
+        m_shared->allSlots.append(slot);
+        // In front, so the slots already holding buffers keep being reused first
+        m_shared->freeSlots.prepend(slot);
+    }
+}
+
+int FramePool::capacity() const
+{
+    QMutexLocker locker(&m_shared->mutex);
+    return m_shared->allSlots.size();
+}
+
+int FramePool::inUse() const
+{
+    QMutexLocker locker(&m_shared->mutex);
+    return m_shared->allSlots.size() - m_shared->freeSlots.size();
+}
@@ -0,0 +1,74 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QSize>
+#include <QAtomicInteger>
+
+/**
+ * @file framepool.h
+ * @brief Defines the FramePool class, a bounded pool of reusable frame buffers.
+ */
+
+/**
+ * @class FramePool
+ * @brief Hands out QImages backed by a fixed set of recycled pixel buffers.
+ *
+ * Allocating a new QImage for every decoded frame churns hundreds of MB/s of
+ * heap per device and makes decoders contend in the allocator. Images from
+ * acquire() wrap a pooled buffer instead; when the last copy of the image is
+ * destroyed (on whichever thread holds it), the buffer goes back to the pool.
+ *
+ * Rows are 64-byte aligned, which suits the SIMD paths of swscale. A slot's
+ * buffer is only reallocated when a larger frame is requested (or a much
+ * smaller one, to give memory back after a window shrinks).
+ *
+ * When every slot is in use the consumer is behind; the ExhaustionPolicy
+ * decides whether the frame is dropped or the pool grows (up to MAX_SLOTS).
+ *
+ * acquire() must be called from one thread (the decoder); images may be
+ * released from any thread. Outstanding images stay valid after the pool
+ * is destroyed.
+ */
+class FramePool
+{
+public:
+    enum class ExhaustionPolicy {
+        DropFrame, // acquire() returns a null image; the caller skips the frame
+        Grow       // A new slot is added, up to MAX_SLOTS
+    };
+
+    static constexpr int MAX_SLOTS = 16;
+
+    explicit FramePool(int capacity = 4, ExhaustionPolicy policy = ExhaustionPolicy::DropFrame);
+    ~FramePool();
+
+    /**
+     * @brief Returns an RGB32 image of the given size backed by a pooled buffer.
+     * @return The image, or a null image if the pool is exhausted under DropFrame
+     *         (or the allocation failed).
+     */
+    QImage acquire(const QSize &size);
+
+    /**
+     * @brief Adds slots until the pool holds @p capacity (at most MAX_SLOTS); never removes any.
+     *
+     * Buffers are only allocated when a slot is first used, so reserved slots
+     * cost nothing until the consumer actually holds that many frames.
+     */
+    void reserve(int capacity);
+
+    int capacity() const;
+    int inUse() const;
+    quint64 droppedFrames() const { return m_dropped.loadRelaxed(); }
+
+private:
+    Q_DISABLE_COPY(FramePool)
+
+    struct Shared;
+    Shared *m_shared;
+    ExhaustionPolicy m_policy;
+    QAtomicInteger<quint64> m_dropped;
+};
+
+#endif // FRAMEPOOL_H
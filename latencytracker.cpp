@@ -0,0 +1,103 @@
+#include "latencytracker.h"
+#include <QStringList>
+#include <chrono>
+
+LatencyTracker::LatencyTracker()
+{
+    for (Histogram &histogram : m_histograms) {
+        histogram.buckets.resize(BUCKET_COUNT);
+    }
+}
+
+qint64 LatencyTracker::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char *LatencyTracker::stageName(Stage stage)
+{
+    switch (stage) {
+    case NetworkStage: return "network";
+    case DecodeStage:  return "decode";
+    case ConvertStage: return "convert";
+    case DisplayStage: return "display";
+    case TotalStage:   return "total";
+    default:           return "?";
+    }
+}
+
+void LatencyTracker::record(const FrameTiming &timing, qint64 presentedUs)
+{
+    if (timing.receivedUs == 0 || timing.parsedUs == 0 || timing.decodedUs == 0 || timing.convertedUs == 0) {
+        return;
+    }
+
+    m_histograms[NetworkStage].add(timing.parsedUs - timing.receivedUs);
+    m_histograms[DecodeStage].add(timing.decodedUs - timing.parsedUs);
+    m_histograms[ConvertStage].add(timing.convertedUs - timing.decodedUs);
+    m_histograms[DisplayStage].add(presentedUs - timing.convertedUs);
+    m_histograms[TotalStage].add(presentedUs - timing.receivedUs);
+}
+
+LatencyTracker::Summary LatencyTracker::summary(Stage stage) const
+{
+    const Histogram &histogram = m_histograms[stage];
+    Summary summary;
+    summary.count = histogram.count;
+    summary.p50Ms = histogram.percentileMs(0.50);
+    summary.p99Ms = histogram.percentileMs(0.99);
+    summary.maxMs = histogram.maxUs / 1000.0;
+    return summary;
+}
+
+QString LatencyTracker::report() const
+{
+    QStringList parts;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const Summary s = summary(static_cast<Stage>(i));
+        parts << QString("%1 %2/%3/%4")
+                     .arg(stageName(static_cast<Stage>(i)))
+                     .arg(s.p50Ms, 0, 'f', 1)
+                     .arg(s.p99Ms, 0, 'f', 1)
+                     .arg(s.maxMs, 0, 'f', 1);
+    }
+    return QString("p50/p99/max ms over %1 frames: %2")
+        .arg(m_histograms[TotalStage].count)
+        .arg(parts.join(", "));
+}
+
+void LatencyTracker::reset()
+{
+    for (Histogram &histogram : m_histograms) {
+        histogram.buckets.fill(0);
+        histogram.count = 0;
+        histogram.maxUs = 0;
+    }
+}
+
+void LatencyTracker::Histogram::add(qint64 us)
+{
+    us = qMax<qint64>(0, us);
+    buckets[static_cast<int>(qMin<qint64>(us / BUCKET_US, BUCKET_COUNT - 1))]++;
+    count++;
+    maxUs = qMax(maxUs, us);
+}
+
+double LatencyTracker::Histogram::percentileMs(double fraction) const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+
+    // Upper edge of the bucket holding the requested rank, capped at the exact maximum
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(fraction * count + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin<qint64>(qint64(i + 1) * BUCKET_US, maxUs) / 1000.0;
+        }
+    }
+    return maxUs / 1000.0;
+}
@@ -0,0 +1,99 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @file latencytracker.h
+ * @brief Defines FrameTiming and the LatencyTracker class, per-frame latency tracing from socket to screen.
+ */
+
+/**
+ * @struct FrameTiming
+ * @brief Timestamps of one frame's way through the client, in LatencyTracker::nowUs() microseconds.
+ *
+ * Set by the decoder thread and carried with the frame (through libavcodec as
+ * the packet's opaque value). 0 means the stage was not traced.
+ */
+struct FrameTiming
+{
+    qint64 receivedUs = 0;   // Packet header read from the socket
+    qint64 parsedUs = 0;     // Payload complete, handed to avcodec_send_packet()
+    qint64 decodedUs = 0;    // Returned by avcodec_receive_frame()
+    qint64 convertedUs = 0;  // convertFrameToImage() done, posted to the mailbox
+};
+
+/**
+ * @class LatencyTracker
+ * @brief Per-device latency histograms of each pipeline stage, with p50/p99/max.
+ *
+ * Stages: network (header to complete payload), decode, convert, display
+ * (mailbox, event loop and paint) and their total. Samples go into fixed
+ * 100 µs buckets, so recording is a few increments and cheap enough to leave
+ * on in release builds; percentiles are read from the buckets.
+ *
+ * Device timestamps use the device's clock, so the time between capture on
+ * the device and arrival is not part of the total.
+ *
+ * Not thread-safe; used from the GUI thread.
+ */
+class LatencyTracker
+{
+public:
+    enum Stage {
+        NetworkStage,
+        DecodeStage,
+        ConvertStage,
+        DisplayStage,
+        TotalStage,
+        STAGE_COUNT
+    };
+
+    struct Summary {
+        quint64 count = 0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    LatencyTracker();
+
+    /**
+     * @brief Monotonic clock shared by all stages, in microseconds. Thread-safe.
+     */
+    static qint64 nowUs();
+
+    static const char *stageName(Stage stage);
+
+    /**
+     * @brief Records a frame that was painted at @p presentedUs.
+     */
+    void record(const FrameTiming &timing, qint64 presentedUs);
+
+    Summary summary(Stage stage) const;
+
+    /**
+     * @brief One-line summary of every stage, e.g. for the log.
+     */
+    QString report() const;
+
+    void reset();
+
+private:
+    static constexpr int BUCKET_US = 100;
+    static constexpr int BUCKET_COUNT = 3000; // Up to 300 ms; slower samples land in the last bucket
+
+    struct Histogram {
+        QVector<quint32> buckets;
+        quint64 count = 0;
+        qint64 maxUs = 0;
+
+        void add(qint64 us);
+        double percentileMs(double fraction) const;
+    };
+
+    Histogram m_histograms[STAGE_COUNT];
+};
+
+#endif // LATENCYTRACKER_H
@@ -1,11 +1,73 @@
 #include "mainwindow.h"
+#include "threadpolicy.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption captureOption("capture",
+                                     "Tee the raw video/audio socket bytes of each session to <file>.",
+                                     "file");
+    QCommandLineOption connectOption("connect",
+                                     "Connect directly to a scrcpy-protocol server on 127.0.0.1:<port> "
+                                     "(e.g. tools/scrcpy-replay) instead of a device. A range such as "
+                                     "27183-27190 opens one session per port; may be repeated.",
+                                     "port");
+    QCommandLineOption metricsOption("metrics",
+                                     "Append per-device live metrics (fps, drops, bitrate, decode time, "
+                                     "queue depth, latency, audio buffer) to <file> as JSON lines, once per second.",
+                                     "file");
+    QCommandLineOption threadPolicyOption("thread-policy",
+                                          "Scheduling of the decoder and recorder threads, e.g. "
+                                          "\"video:nice=-5:cpus=2-7;audio:sched=rr:priority=10\" "
+                                          "(roles video, audio, recording; nice, sched=other|fifo|rr, priority, cpus).",
+                                          "spec");
+    parser.addOption(captureOption);
+    parser.addOption(connectOption);
+    parser.addOption(metricsOption);
+    parser.addOption(threadPolicyOption);
+    parser.process(a);
+
+    if (parser.isSet(threadPolicyOption)) {
+        QString error;
+        if (!ThreadPolicy::instance().parse(parser.value(threadPolicyOption), &error)) {
+            qCritical("Invalid --thread-policy: %s", qPrintable(error));
+            return 1;
+        }
+    }
+
     MainWindow w;
+    if (parser.isSet(captureOption)) {
+        w.setCaptureFile(parser.value(captureOption));
+    }
+    if (parser.isSet(metricsOption)) {
+        w.setMetricsFile(parser.value(metricsOption));
+    }
     w.show();
+
+    // Ports are checked before any session starts, so a typo opens no windows
+    QList<quint16> directPorts;
+    for (const QString &value : parser.values(connectOption)) {
+        const QStringList bounds = value.split('-');
+        bool firstOk = false;
+        bool lastOk = false;
+        const quint16 first = bounds.value(0).trimmed().toUShort(&firstOk);
+        const quint16 last = (bounds.size() == 2) ? bounds[1].trimmed().toUShort(&lastOk) : first;
+        if (!firstOk || (bounds.size() == 2 && !lastOk) || bounds.size() > 2 || first == 0 || last < first) {
+            qCritical("Invalid --connect port: %s", qPrintable(value));
+            return 1;
+        }
+        for (int port = first; port <= last; ++port) {
+            directPorts.append(static_cast<quint16>(port));
+        }
+    }
+    for (quint16 port : std::as_const(directPorts)) {
+        w.startDirectSession(port);
+    }
     return a.exec();
 }
@@ -3,6 +3,8 @@
 #include "adbprocess.h"
 #include "devicemanager.h"
 #include "uistatemanager.h"
+#include "portallocator.h"
+#include "sessionscheduler.h"
 #include <QDateTime>
 #include <QListWidgetItem>
 #include <QFileDialog>
@@ -48,6 +50,12 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->comboBox_videoCodec->setItemData(0, "h264");
     ui->comboBox_videoCodec->setItemData(1, "h265");
     ui->comboBox_videoCodec->setItemData(2, "av1");
+    ui->comboBox_scaleQuality->setItemData(0, "fast");
+    ui->comboBox_scaleQuality->setItemData(1, "bilinear");
+    ui->comboBox_scaleQuality->setItemData(2, "bicubic");
+    ui->comboBox_decoderProfile->setItemData(0, "low-latency");
+    ui->comboBox_decoderProfile->setItemData(1, "balanced");
+    ui->comboBox_decoderProfile->setItemData(2, "throughput");
     ui->comboBox_audioSource->setItemData(0, "output");
     ui->comboBox_audioSource->setItemData(1, "playback");
     ui->comboBox_audioSource->setItemData(2, "mic");
@@ -71,6 +79,9 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->comboBox_recordFormat->setItemData(1, "mp4");
     ui->comboBox_recordFormat->setItemData(2, "mkv");
 
+    mSessionScheduler = new SessionScheduler(0, this);
+    connect(mSessionScheduler, &SessionScheduler::logMessage, this, &MainWindow::onLogMessage);
+
     mUiStateManager = new UiStateManager(ui, this);
     mUiStateManager->setDeviceWindowsMap(&mDeviceWindows);
     mUiStateManager->initializeStates();
@@ -150,19 +161,30 @@ void MainWindow::handleExitAction()
 void MainWindow::handleConnectAllUsbAction()
 {
     onLogMessage("Attempting to connect to all available USB devices...");
-    bool foundDevice = false;
+    QStringList serials;
     for (int i = 0; i < ui->listWidget_usbDevices->count(); ++i) {
         QListWidgetItem* item = ui->listWidget_usbDevices->item(i);
         QString itemText = item->text();
         if (itemText.contains("(device)")) {
-            foundDevice = true;
-            QString serial = itemText.left(itemText.indexOf(' '));
-            startDeviceWindow(serial);
+            serials << itemText.left(itemText.indexOf(' '));
         }
     }
-    if (!foundDevice) {
+    if (serials.isEmpty()) {
         onLogMessage("No USB devices with status 'device' were found.");
+        return;
+    }
+
+    // Gather and validate once for the whole batch instead of once per device.
+    ScrcpyOptions options = gatherScrcpyOptions();
+    if (!validateOptions(options)) {
+        onLogMessage("Error: Configuration validation failed. Connection cancelled.");
+        return;
     }
+    for (const QString &serial : serials) {
+        startDeviceWindow(serial, options);
+    }
+    onLogMessage(QString("Queued %1 device(s), up to %2 connecting in parallel.")
+                     .arg(serials.size()).arg(mSessionScheduler->maxConcurrent()));
 }
 
 // --- "View" Menu Slot Implementations ---
@@ -350,6 +372,13 @@ void MainWindow::onDeviceWindowClosed(const QString &serial)
 {
     onLogMessage(QString("Window for device %1 has been closed.").arg(serial));
     delete mDeviceWindows.take(serial); // Take the pointer and delete the object.
+
+    // Every closed session must have released its forward port by now.
+    const QMap<quint16, QString> leaked = PortAllocator::instance().reclaimLeaked(mDeviceWindows.keys());
+    for (auto it = leaked.cbegin(); it != leaked.cend(); ++it) {
+        onLogMessage(QString("Warning: Port %1 leaked by device %2 has been reclaimed.").arg(it.key()).arg(it.value()));
+    }
+
     mUiStateManager->removeDeviceFromStatusTable(serial);
     mUiStateManager->updateConnectedDeviceStatus();
 }
@@ -364,6 +393,8 @@ ScrcpyOptions MainWindow::gatherScrcpyOptions() const
     opts.max_fps = ui->spinBox_maxFPS->value();
     opts.video_codec = ui->comboBox_videoCodec->currentData().toString();
     opts.display_id = ui->spinBox_displayID->value();
+    opts.scale_quality = ui->comboBox_scaleQuality->currentData().toString();
+    opts.decoder_profile = ui->comboBox_decoderProfile->currentData().toString();
     opts.video = !ui->checkBox_noVideo->isChecked();
     opts.no_video_playback = ui->checkBox_noVideoPlayback->isChecked();
     // --- Audio Options ---
@@ -394,10 +425,13 @@ ScrcpyOptions MainWindow::gatherScrcpyOptions() const
     opts.always_on_top = ui->checkBox_alwaysOnTop->isChecked();
     opts.window_borderless = ui->checkBox_windowBorderless->isChecked();
     opts.window_title = ui->lineEdit_windowTitle->text();
+    opts.reconnect = ui->checkBox_forceReconnect->isChecked();
     // --- Recording Options ---
     opts.record_file = ui->lineEdit_recordFile->text();
     opts.record_format = ui->comboBox_recordFormat->currentData().toString();
     opts.no_playback = ui->checkBox_noPlayback->isChecked();
+    // --- Benchmarking (command line only) ---
+    opts.capture_file = mCaptureFile;
     return opts;
 }
 
@@ -443,12 +477,43 @@ void MainWindow::handleSaveRecordAsClick()
     }
 }
 
+void MainWindow::setCaptureFile(const QString &filePath)
+{
+    mCaptureFile = filePath;
+    onLogMessage(QString("Capturing raw streams to %1").arg(QDir::toNativeSeparators(filePath)));
+}
+
+void MainWindow::setMetricsFile(const QString &filePath)
+{
+    mMetricsExporter = QSharedPointer<MetricsExporter>::create(filePath);
+    if (mMetricsExporter->isOpen()) {
+        onLogMessage(QString("Exporting device metrics to %1").arg(QDir::toNativeSeparators(filePath)));
+    } else {
+        onLogMessage(QString("Error: Cannot open metrics file %1").arg(QDir::toNativeSeparators(filePath)));
+    }
+}
+
+void MainWindow::onDeviceMetrics(const DeviceMetrics &metrics)
+{
+    if (mMetricsExporter) {
+        mMetricsExporter->write(metrics);
+    }
+    if (ui->checkBox_printFPS->isChecked()) {
+        onLogMessage(metrics.toString());
+    }
+}
+
+void MainWindow::startDirectSession(quint16 port)
+{
+    ScrcpyOptions options = gatherScrcpyOptions();
+    options.direct_port = port;
+    startDeviceWindow(QString("direct:%1").arg(port), options);
+}
+
 void MainWindow::startDeviceWindow(const QString &serial)
 {
     if (mDeviceWindows.contains(serial)) {
-        onLogMessage(QString("Info: The window for device %1 is already open.").arg(serial));
-        mDeviceWindows[serial]->activateWindow();
-        mDeviceWindows[serial]->raise();
+        startDeviceWindow(serial, ScrcpyOptions()); // Only raises the existing window.
         return;
     }
 
@@ -457,16 +522,30 @@ void MainWindow::startDeviceWindow(const QString &serial)
         onLogMessage("Error: Configuration validation failed. Connection cancelled.");
         return;
     }
+    startDeviceWindow(serial, options);
+}
+
+void MainWindow::startDeviceWindow(const QString &serial, const ScrcpyOptions &options)
+{
+    if (mDeviceWindows.contains(serial)) {
+        onLogMessage(QString("Info: The window for device %1 is already open.").arg(serial));
+        mDeviceWindows[serial]->activateWindow();
+        mDeviceWindows[serial]->raise();
+        return;
+    }
 
     onLogMessage(QString("Creating window for device %1...").arg(serial));
     DeviceWindow *deviceWindow = new DeviceWindow(serial, options, nullptr);
     connect(deviceWindow, &DeviceWindow::windowClosed, this, &MainWindow::onDeviceWindowClosed);
     connect(deviceWindow, &DeviceWindow::statusUpdated, mUiStateManager, &UiStateManager::updateDeviceStatusInfo);
+    connect(deviceWindow, &DeviceWindow::metricsUpdated, mUiStateManager, &UiStateManager::updateDeviceMetrics);
+    connect(deviceWindow, &DeviceWindow::metricsUpdated, this, &MainWindow::onDeviceMetrics);
 
     mDeviceWindows.insert(serial, deviceWindow);
     mUiStateManager->addDeviceToStatusTable(serial);
     mUiStateManager->updateConnectedDeviceStatus();
     deviceWindow->show();
+    mSessionScheduler->enqueue(deviceWindow);
 }
 
 void MainWindow::handleEnableTcpIpClick()
@@ -523,7 +602,18 @@ void MainWindow::handleConnectWifiClick()
             mDeviceManager->refreshDevices();
             process->deleteLater();
         });
-        process->execute("", {"connect", fullAddress});
+
+        // "Force Reconnect" drops a stale adb connection first, like scrcpy's --tcpip=+ip:port
+        if (ui->checkBox_forceReconnect->isChecked()) {
+            AdbProcess *disconnectProcess = new AdbProcess(this);
+            connect(disconnectProcess, &AdbProcess::finished, this, [process, disconnectProcess, fullAddress]() {
+                disconnectProcess->deleteLater();
+                process->execute("", {"connect", fullAddress});
+            });
+            disconnectProcess->execute("", {"disconnect", fullAddress});
+        } else {
+            process->execute("", {"connect", fullAddress});
+        }
     } else {
         // If devices are selected in the list, launch scrcpy windows for them.
         for (QListWidgetItem *item : selectedItems) {
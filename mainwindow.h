@@ -7,6 +7,10 @@
 #include <QMap>
 #include "scrcpyoptions.h"
 #include "uistatemanager.h"
+#include "metricsexporter.h"
+#include <QSharedPointer>
+
+class SessionScheduler;
 
 namespace Ui {
 class MainWindow;
@@ -28,6 +32,27 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    /**
+     * @brief Tees the raw socket bytes of every new session into a capture file (--capture).
+     * @param filePath The capture file; sessions started concurrently get their serial appended.
+     */
+    void setCaptureFile(const QString &filePath);
+
+    /**
+     * @brief Opens a session against a scrcpy-protocol server on 127.0.0.1:port (--connect).
+     *
+     * No adb is involved, so a capture served by tools/scrcpy-replay can be
+     * decoded and rendered on machines without any device attached.
+     * @param port The local port the replay server listens on.
+     */
+    void startDirectSession(quint16 port);
+
+    /**
+     * @brief Appends the live metrics of every session to a JSON lines file (--metrics).
+     * @param filePath The file, one JSON object per device and sample, e.g. for monitoring to scrape.
+     */
+    void setMetricsFile(const QString &filePath);
+
 private slots:
     // --- Core Logic Slots (Not directly tied to UI interaction) ---
     /**
@@ -48,6 +73,12 @@ private slots:
      */
     void onDeviceWindowClosed(const QString &serial);
 
+    /**
+     * @brief Exports a device's metrics sample and logs it when "Print FPS" is checked.
+     * @param metrics The sample; the status table is updated by the UiStateManager.
+     */
+    void onDeviceMetrics(const DeviceMetrics &metrics);
+
     // --- Button Click Handler Slots (Manually connected in the constructor) ---
     void handleConnectUsbClick();
     void handleEnableTcpIpClick();
@@ -119,11 +150,25 @@ private:
      */
     void startDeviceWindow(const QString &serial);
 
+    /**
+     * @brief Creates and shows a new DeviceWindow using already validated options.
+     *
+     * The window's connection bring-up is queued on the SessionScheduler, so many
+     * windows can be started at once and connect in parallel.
+     * @param serial The serial number of the device to connect to.
+     * @param options The validated options for the session.
+     */
+    void startDeviceWindow(const QString &serial, const ScrcpyOptions &options);
+
     Ui::MainWindow *ui;
     DeviceManager *mDeviceManager;
     // A map to keep track of active device windows, using the serial number as the key.
     QMap<QString, DeviceWindow*> mDeviceWindows;
     UiStateManager *mUiStateManager;
+    // Runs device bring-ups concurrently with a bounded number in flight.
+    SessionScheduler *mSessionScheduler;
+    QString mCaptureFile;
+    QSharedPointer<MetricsExporter> mMetricsExporter;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,72 @@
+#include "metricsexporter.h"
+#include <QDebug>
+#include <QJsonDocument>
+
+QJsonObject DeviceMetrics::toJson() const
+{
+    return QJsonObject{
+        {"serial", serial},
+        {"timestamp_ms", timestampMs},
+        {"fps_in", fpsIn},
+        {"fps_out", fpsOut},
+        {"dropped_frames", static_cast<qint64>(droppedFrames)},
+        {"static_frames", static_cast<qint64>(staticFrames)},
+        {"bitrate_kbps", bitrateKbps},
+        {"decode_ms", decodeMs},
+        {"queue_depth", queueDepth},
+        {"latency_p50_ms", latencyP50Ms},
+        {"latency_p99_ms", latencyP99Ms},
+        {"presenting", presenting},
+        {"reconnects", reconnects},
+        {"downtime_ms", downtimeMs},
+        {"audio", audio},
+        {"audio_buffer_ms", audioBufferMs},
+        {"audio_target_ms", audioTargetMs},
+        {"audio_underruns", static_cast<qint64>(audioUnderruns)},
+        {"audio_dropped_ms", static_cast<qint64>(audioDroppedMs)},
+        {"audio_drift_ppm", audioDriftPpm},
+    };
+}
+
+QString DeviceMetrics::toString() const
+{
+    return QString("%1: %2 fps in, %3 fps out, %4 dropped, %5 static, %6 kbps, decode %7 ms, queue %8, latency p50/p99 %9/%10 ms%11%12%13")
+        .arg(serial)
+        .arg(fpsIn, 0, 'f', 1)
+        .arg(fpsOut, 0, 'f', 1)
+        .arg(droppedFrames)
+        .arg(staticFrames)
+        .arg(bitrateKbps, 0, 'f', 0)
+        .arg(decodeMs, 0, 'f', 1)
+        .arg(queueDepth)
+        .arg(latencyP50Ms, 0, 'f', 1)
+        .arg(latencyP99Ms, 0, 'f', 1)
+        .arg(presenting ? QString() : QString(" (hidden, decode-only)"))
+        .arg(reconnects > 0 ? QString(", %1 reconnects, %2 ms down").arg(reconnects).arg(downtimeMs) : QString())
+        .arg(audio ? QString(", audio %1/%2 ms, %3 underruns, %4 ppm drift")
+                         .arg(audioBufferMs).arg(audioTargetMs).arg(audioUnderruns).arg(audioDriftPpm)
+                   : QString());
+}
+
+MetricsExporter::MetricsExporter(const QString &filePath)
+    : m_file(filePath)
+{
+    // Appended to, so a monitoring agent's offset stays valid across restarts
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "[MetricsExporter] Cannot open" << filePath << ":" << m_file.errorString();
+        return;
+    }
+    qDebug() << "[MetricsExporter] Exporting metrics to" << filePath;
+}
+
+void MetricsExporter::write(const DeviceMetrics &metrics)
+{
+    if (!m_file.isOpen() || m_failed) return;
+
+    QByteArray line = QJsonDocument(metrics.toJson()).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    if (m_file.write(line) != line.size() || !m_file.flush()) {
+        qWarning() << "[MetricsExporter] Write failed, export stopped:" << m_file.errorString();
+        m_failed = true;
+    }
+}
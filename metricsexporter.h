@@ -0,0 +1,75 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QString>
+#include <QFile>
+#include <QJsonObject>
+
+/**
+ * @file metricsexporter.h
+ * @brief Defines DeviceMetrics and the MetricsExporter class, which writes them as JSON lines.
+ */
+
+/**
+ * @struct DeviceMetrics
+ * @brief One sample of a device session's live video and audio metrics.
+ *
+ * Sampled by DeviceWindow once per DisplayConfig::METRICS_INTERVAL_MS; rates
+ * and percentiles cover that interval, the dropped and underrun counts the
+ * whole session. The audio fields stay 0 while audio is off.
+ */
+struct DeviceMetrics
+{
+    QString serial;
+    qint64 timestampMs = 0;      // Wall clock, milliseconds since the epoch
+    double fpsIn = 0.0;          // Frames decoded
+    double fpsOut = 0.0;         // Frames painted
+    quint64 droppedFrames = 0;   // Replaced in the mailbox or skipped for lack of buffers
+    quint64 staticFrames = 0;    // Identical to the frame on screen, so neither converted nor painted
+    double bitrateKbps = 0.0;    // Video socket bytes, including framing
+    double decodeMs = 0.0;       // Median decode time
+    int queueDepth = 0;          // Converted frames held (mailbox, display, converter)
+    double latencyP50Ms = 0.0;   // Socket to paint, see LatencyTracker
+    double latencyP99Ms = 0.0;
+    bool presenting = true;      // False while the window is hidden and the session is decode-only
+    int reconnects = 0;          // Times the session was resumed after losing the device
+    qint64 downtimeMs = 0;       // Total time without a stream between those reconnects
+
+    bool audio = false;          // Audio is forwarded and played
+    int audioBufferMs = 0;       // Jitter buffer level, see AudioJitterBuffer
+    int audioTargetMs = 0;       // Its current (adaptive) target level
+    quint64 audioUnderruns = 0;  // Times the sound card ran dry
+    quint64 audioDroppedMs = 0;  // Audio discarded to bound latency
+    int audioDriftPpm = 0;       // Clock drift correction, positive = playing faster
+
+    QJsonObject toJson() const;
+
+    /**
+     * @brief One-line summary for the log, e.g. with "Print FPS" enabled.
+     */
+    QString toString() const;
+};
+
+/**
+ * @class MetricsExporter
+ * @brief Appends every DeviceMetrics sample to a file as one JSON object per line.
+ *
+ * The file is flushed after each line, so monitoring can tail or scrape it
+ * while sessions are running. Used from the GUI thread.
+ */
+class MetricsExporter
+{
+public:
+    explicit MetricsExporter(const QString &filePath);
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_file.fileName(); }
+
+    void write(const DeviceMetrics &metrics);
+
+private:
+    QFile m_file;
+    bool m_failed = false;
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,70 @@
+#include "portallocator.h"
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QDebug>
+
+PortAllocator &PortAllocator::instance()
+{
+    static PortAllocator allocator;
+    return allocator;
+}
+
+quint16 PortAllocator::acquire(const QString &owner)
+{
+    const int rangeSize = LAST_PORT - FIRST_PORT + 1;
+
+    // Walk the range once, starting after the most recently leased port.
+    for (int i = 0; i < rangeSize; ++i) {
+        quint16 port = mNextPort;
+        mNextPort = (mNextPort == LAST_PORT) ? FIRST_PORT : mNextPort + 1;
+
+        if (mLeases.contains(port) || !isPortBindable(port)) {
+            continue;
+        }
+
+        mLeases.insert(port, owner);
+        qDebug() << "[PortAllocator] Leased port" << port << "to" << owner;
+        return port;
+    }
+
+    qWarning() << "[PortAllocator] No free port left in range"
+               << FIRST_PORT << "-" << LAST_PORT << "for" << owner;
+    return 0;
+}
+
+void PortAllocator::release(quint16 port)
+{
+    if (mLeases.remove(port) > 0) {
+        qDebug() << "[PortAllocator] Released port" << port;
+    }
+}
+
+QMap<quint16, QString> PortAllocator::reclaimLeaked(const QStringList &activeOwners)
+{
+    QMap<quint16, QString> leaked;
+    for (auto it = mLeases.begin(); it != mLeases.end();) {
+        if (!activeOwners.contains(it.value())) {
+            qWarning() << "[PortAllocator] Reclaiming leaked port" << it.key() << "from" << it.value();
+            leaked.insert(it.key(), it.value());
+            it = mLeases.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return leaked;
+}
+
+QMap<quint16, QString> PortAllocator::leases() const
+{
+    return mLeases;
+}
+
+bool PortAllocator::isPortBindable(quint16 port) const
+{
+    QTcpServer probe;
+    if (!probe.listen(QHostAddress::LocalHost, port)) {
+        return false;
+    }
+    probe.close();
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef PORTALLOCATOR_H
+#define PORTALLOCATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+/**
+ * @file portallocator.h
+ * @brief Defines the PortAllocator class, which hands out local forward ports to device sessions.
+ */
+
+/**
+ * @class PortAllocator
+ * @brief Leases local TCP ports from a fixed range so several devices can be mirrored at once.
+ *
+ * Every DeviceWindow needs its own "adb forward" port. Ports are handed out
+ * round-robin over the range, so a port released by a closing session (whose
+ * asynchronous "adb forward --remove" may still be running) is not reused
+ * immediately. Each lease records its owner, which allows leases that outlive
+ * their session to be detected and reclaimed.
+ *
+ * The allocator is a process-wide singleton and must only be used from the GUI thread.
+ */
+class PortAllocator
+{
+public:
+    static constexpr quint16 FIRST_PORT = 27183; // scrcpy's default port
+    static constexpr quint16 LAST_PORT = 27399;
+
+    static PortAllocator &instance();
+
+    /**
+     * @brief Leases a free local port.
+     * @param owner Identifies the lease holder (the device serial) for leak reports.
+     * @return The leased port, or 0 if every port in the range is in use.
+     */
+    quint16 acquire(const QString &owner);
+
+    /**
+     * @brief Returns a leased port to the pool. Releasing an unleased port is a no-op.
+     */
+    void release(quint16 port);
+
+    /**
+     * @brief Reclaims leases whose owner is not in the given list of active sessions.
+     * @param activeOwners The owners that are still running.
+     * @return The reclaimed ports mapped to the owner that leaked them.
+     */
+    QMap<quint16, QString> reclaimLeaked(const QStringList &activeOwners);
+
+    /**
+     * @brief Returns the currently leased ports mapped to their owners.
+     */
+    QMap<quint16, QString> leases() const;
+
+private:
+    PortAllocator() = default;
+    Q_DISABLE_COPY(PortAllocator)
+
+    // Checks that no other process (e.g. another scrcpy instance) holds the port.
+    bool isPortBindable(quint16 port) const;
+
+    QMap<quint16, QString> mLeases;
+    quint16 mNextPort = FIRST_PORT;
+};
+
+#endif // PORTALLOCATOR_H
@@ -1,8 +1,8 @@
-QT       += core gui network
+QT       += core gui network multimedia
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++17
+CONFIG += c++17 simd
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -10,25 +10,66 @@ CONFIG += c++17
 
 SOURCES += \
     adbprocess.cpp \
+    audiodecoderthread.cpp \
+    audiojitterbuffer.cpp \
     controlsender.cpp \
+    decoderprofile.cpp \
+    decoderthreadbudget.cpp \
     devicemanager.cpp \
     devicewindow.cpp \
+    framechangedetector.cpp \
+    framemailbox.cpp \
+    framepool.cpp \
+    latencytracker.cpp \
     main.cpp \
     mainwindow.cpp \
+    metricsexporter.cpp \
+    portallocator.cpp \
     scrcpyoptions.cpp \
+    serverjarcache.cpp \
+    sessionscheduler.cpp \
+    streamcapture.cpp \
+    streamrecorder.cpp \
+    threadpolicy.cpp \
     uistatemanager.cpp \
-    videodecoderthread.cpp
+    videodecoderthread.cpp \
+    videowidget.cpp \
+    yuvconverter.cpp \
+    yuvkernels_neon.cpp
+
+# Built with their instruction set enabled; YuvConverter checks the CPU before using them
+SSE4_1_SOURCES += yuvkernels_sse41.cpp
+AVX2_SOURCES += yuvkernels_avx2.cpp
 
 HEADERS += \
     adbprocess.h \
+    audiodecoderthread.h \
+    audiojitterbuffer.h \
     androidkeycodes.h \
     controlsender.h \
+    decoderprofile.h \
+    decoderthreadbudget.h \
     devicemanager.h \
     devicewindow.h \
+    framechangedetector.h \
+    framemailbox.h \
+    framepool.h \
+    latencytracker.h \
     mainwindow.h \
+    metricsexporter.h \
+    portallocator.h \
     scrcpyoptions.h \
+    serverjarcache.h \
+    sessionscheduler.h \
+    streamcapture.h \
+    streamrecorder.h \
+    threadpolicy.h \
     uistatemanager.h \
-    videodecoderthread.h
+    videodecoderthread.h \
+    videowidget.h \
+    yuvconverter.h \
+    yuvkernels.h \
+    yuvkernels_impl.h
 
 FORMS += \
     devicewindow.ui \
@@ -1,8 +1,5 @@
 #include "scrcpyoptions.h"
 
-// A constant for the temporary filename used for recordings on the device.
-const QString DEVICE_RECORD_FILENAME = "temp_record_file";
-
 ScrcpyOptions::ScrcpyOptions()
 {
     // --- Set default values for all options ---
@@ -12,6 +9,7 @@ ScrcpyOptions::ScrcpyOptions()
     // Core
     logLevel = "info";
     tunnel_forward = true;
+    scid = -1; // Assigned per session by DeviceWindow.
 
     // Video
     video = true;
@@ -52,11 +50,18 @@ ScrcpyOptions::ScrcpyOptions()
     fullscreen = false;
     always_on_top = false;
     window_borderless = false;
+    scale_quality = "fast";
+    hidden_skip_nonref = true;
+    decoder_profile = "balanced";
+    reconnect = false;
 
     // Recording
     record_format = "auto";
     no_playback = false;
     no_video_playback = false;
+
+    // Benchmarking
+    direct_port = 0;
 }
 
 QStringList ScrcpyOptions::toAdbShellArgs() const
@@ -72,6 +77,7 @@ QStringList ScrcpyOptions::toAdbShellArgs() const
 
     // Append core parameters.
     args << QString("log_level=%1").arg(logLevel);
+    if (scid >= 0) args << QString("scid=%1").arg(scid, 8, 16, QChar('0'));
 
     // Append video parameters only if video is enabled.
     args << QString("video=%1").arg(video ? "true" : "false");
@@ -100,7 +106,6 @@ QStringList ScrcpyOptions::toAdbShellArgs() const
         if (audio_source != "output") args << QString("audio_source=%1").arg(audio_source);
         if (audio_bit_rate != 128000) args << QString("audio_bit_rate=%1").arg(audio_bit_rate);
         if (audio_codec != "opus") args << QString("audio_codec=%1").arg(audio_codec);
-        if (audio_buffer != 50) args << QString("audio_buffer=%1").arg(audio_buffer);
         if (audio_dup) args << "audio_dup=true";
         if (require_audio) args << "require_audio=true";
     }
@@ -115,18 +120,6 @@ QStringList ScrcpyOptions::toAdbShellArgs() const
     if (mouse_mode != "sdk") args << QString("mouse=%1").arg(mouse_mode);
     if (otg) args << "otg=true";
 
-    // Append recording parameters.
-    if (!record_file.isEmpty()) {
-        // The PC path is for the client, but we must tell the server to record to a temporary file on the device.
-        QString format = (record_format == "auto" ? "mkv" : record_format);
-        QString device_path = QString("/sdcard/%1.%2").arg(DEVICE_RECORD_FILENAME).arg(format);
-
-        args << QString("record_file=%1").arg(device_path);
-
-        if (record_format != "auto") {
-            args << QString("record_format=%1").arg(record_format);
-        }
-    }
     if (no_playback) args << "no_playback=true";
 
     // Append fixed parameters required for this client's operation.
@@ -136,4 +129,10 @@ QStringList ScrcpyOptions::toAdbShellArgs() const
     return args;
 }
 
-
+QString ScrcpyOptions::socketName() const
+{
+    if (scid < 0) {
+        return "scrcpy";
+    }
+    return QString("scrcpy_%1").arg(scid, 8, 16, QChar('0'));
+}
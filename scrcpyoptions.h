@@ -29,10 +29,17 @@ public:
      */
     QStringList toAdbShellArgs() const;
 
+    /**
+     * @brief Returns the name of the device-side abstract socket for this session.
+     * @return "scrcpy" when no session id is set, otherwise "scrcpy_<scid as 8 hex digits>".
+     */
+    QString socketName() const;
+
     // --- Core & General Parameters ---
     QString version;          // The version of the scrcpy server to be executed.
     QString logLevel;         // Log level for the server (e.g., "info", "debug").
     bool tunnel_forward;      // Whether to use a forward tunnel for the connection.
+    qint32 scid;              // 31-bit session id that makes the device socket name unique. -1 for none.
 
     // --- Video Parameters ---
     bool video;               // Enable/disable video streaming.
@@ -49,7 +56,7 @@ public:
     quint32 audio_bit_rate;   // Audio bitrate in bits per second.
     QString audio_codec;      // Audio codec to use ("opus", "aac", "flac", "raw").
     QString audio_source;     // Source of the audio ("output", "mic").
-    quint16 audio_buffer;     // Audio buffer size in milliseconds.
+    quint16 audio_buffer;     // Client-side base jitter buffer latency in milliseconds (not sent to the server).
     bool audio_dup;           // Duplicate audio output to the device's speakers.
     bool require_audio;       // Abort if audio capture fails.
 
@@ -79,12 +86,20 @@ public:
     bool always_on_top;
     bool window_borderless;
     QString window_title;
+    QString scale_quality;    // Filter for the decoder's downscale to window size ("fast", "bilinear", "bicubic").
+    bool hidden_skip_nonref;  // While the window is hidden (decode-only), also skip non-reference frames.
+    QString decoder_profile;  // Latency vs. throughput trade-offs of the decoder ("low-latency", "balanced", "throughput"), see DecoderProfile.
+    bool reconnect;           // Bring a dropped session back in the same window; wireless devices are reconnected via adb first.
 
-    // These recording parameters ARE passed to the scrcpy server.
-    QString record_file;      // PC path to save the recording. The server will use a temp path.
-    QString record_format;    // Recording container format ("mp4", "mkv").
+    // Recording happens on the host (StreamRecorder remuxes the received packets).
+    QString record_file;      // PC path to save the recording.
+    QString record_format;    // Recording container format ("auto", "mp4", "mkv").
     bool no_playback;         // Record but do not display the stream on the client.
     bool no_video_playback;   // For audio-only mirroring, disable the black video window.
+
+    // Benchmarking: sessions without a phone (see tools/scrcpy-replay).
+    QString capture_file;     // Tee the raw video/audio socket bytes to this file (StreamCapture format).
+    quint16 direct_port;      // Non-zero: connect straight to a scrcpy-protocol server on 127.0.0.1:direct_port, skipping adb.
 };
 
 #endif // SCRCPYOPTIONS_H
@@ -0,0 +1,73 @@
+#include "serverjarcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace {
+struct LocalHashEntry {
+    qint64 size = -1;
+    QDateTime lastModified;
+    QByteArray hash;
+};
+}
+
+QByteArray ServerJarCache::localHash(const QString &filePath)
+{
+    static QHash<QString, LocalHashEntry> cache;
+
+    QFileInfo info(filePath);
+    LocalHashEntry &entry = cache[info.absoluteFilePath()];
+    if (entry.size == info.size() && entry.lastModified == info.lastModified() && !entry.hash.isEmpty()) {
+        return entry.hash;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[ServerJarCache] Cannot read" << filePath;
+        return QByteArray();
+    }
+
+    QCryptographicHash hasher(QCryptographicHash::Sha256);
+    if (!hasher.addData(&file)) {
+        return QByteArray();
+    }
+
+    entry.size = info.size();
+    entry.lastModified = info.lastModified();
+    entry.hash = hasher.result().toHex();
+    return entry.hash;
+}
+
+QByteArray ServerJarCache::knownDeviceHash(const QString &serial)
+{
+    QSettings index(indexFilePath(), QSettings::IniFormat);
+    index.beginGroup("Devices");
+    return index.value(serial).toByteArray();
+}
+
+void ServerJarCache::rememberDeviceHash(const QString &serial, const QByteArray &hash)
+{
+    QSettings index(indexFilePath(), QSettings::IniFormat);
+    index.beginGroup("Devices");
+    index.setValue(serial, hash);
+}
+
+void ServerJarCache::forgetDevice(const QString &serial)
+{
+    QSettings index(indexFilePath(), QSettings::IniFormat);
+    index.beginGroup("Devices");
+    index.remove(serial);
+}
+
+QString ServerJarCache::indexFilePath()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dir);
+    return QDir(dir).filePath("server-index.ini");
+}
@@ -0,0 +1,52 @@
+#ifndef SERVERJARCACHE_H
+#define SERVERJARCACHE_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @file serverjarcache.h
+ * @brief Defines the ServerJarCache class, which tracks which devices already hold the current scrcpy-server.
+ */
+
+/**
+ * @class ServerJarCache
+ * @brief Avoids redundant "adb push" of the scrcpy-server jar.
+ *
+ * The SHA-256 of the local jar is compared with the hash of the copy on the device.
+ * The last verified hash per device serial is kept in a small persistent index, so
+ * a reconnect to a device that already has the identical jar needs neither a push
+ * nor a round trip to hash the remote file.
+ *
+ * All functions must be called from the GUI thread.
+ */
+class ServerJarCache
+{
+public:
+    /**
+     * @brief Returns the hex SHA-256 of a local file. Cached while the file's size and mtime are unchanged.
+     * @param filePath The local path of the server jar.
+     * @return The lowercase hex digest, or an empty array if the file cannot be read.
+     */
+    static QByteArray localHash(const QString &filePath);
+
+    /**
+     * @brief Returns the hash of the jar last verified to be on the device, or an empty array if unknown.
+     */
+    static QByteArray knownDeviceHash(const QString &serial);
+
+    /**
+     * @brief Records that the device now holds a jar with the given hash.
+     */
+    static void rememberDeviceHash(const QString &serial, const QByteArray &hash);
+
+    /**
+     * @brief Drops the index entry for a device, forcing a check (and push if needed) next time.
+     */
+    static void forgetDevice(const QString &serial);
+
+private:
+    static QString indexFilePath();
+};
+
+#endif // SERVERJARCACHE_H
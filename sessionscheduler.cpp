@@ -0,0 +1,59 @@
+#include "sessionscheduler.h"
+#include "devicewindow.h"
+#include <QThread>
+#include <QDebug>
+
+SessionScheduler::SessionScheduler(int maxConcurrent, QObject *parent)
+    : QObject(parent),
+      // Bring-up is mostly waiting on adb, so allow at least a few in flight even on small hosts.
+      mMaxConcurrent(maxConcurrent > 0 ? maxConcurrent : qMax(8, QThread::idealThreadCount()))
+{
+}
+
+void SessionScheduler::enqueue(DeviceWindow *window)
+{
+    if (!window) return;
+
+    connect(window, &DeviceWindow::bringUpFinished,
+            this, &SessionScheduler::onBringUpFinished, Qt::UniqueConnection);
+    connect(window, &QObject::destroyed,
+            this, &SessionScheduler::onWindowDestroyed, Qt::UniqueConnection);
+
+    mPending.enqueue(window);
+    dispatch();
+}
+
+void SessionScheduler::dispatch()
+{
+    while (mRunning.size() < mMaxConcurrent && !mPending.isEmpty()) {
+        QPointer<DeviceWindow> window = mPending.dequeue();
+        if (!window) continue; // Closed while waiting.
+
+        mRunning.insert(window.data());
+        QMetaObject::invokeMethod(window.data(), &DeviceWindow::startStreaming, Qt::QueuedConnection);
+    }
+
+    if (!mPending.isEmpty()) {
+        qDebug() << "[SessionScheduler]" << mRunning.size() << "bring-ups running,"
+                 << mPending.size() << "waiting";
+    }
+}
+
+void SessionScheduler::onBringUpFinished(const QString &serial, bool success, const QString &stageTimings)
+{
+    if (!mRunning.remove(sender())) return;
+
+    if (success) {
+        emit logMessage(QString("Device %1 connected (%2).").arg(serial, stageTimings));
+    } else {
+        emit logMessage(QString("Device %1 failed to connect (%2).").arg(serial, stageTimings));
+    }
+    dispatch();
+}
+
+void SessionScheduler::onWindowDestroyed(QObject *window)
+{
+    if (mRunning.remove(window)) {
+        dispatch();
+    }
+}
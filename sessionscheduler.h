@@ -0,0 +1,68 @@
+#ifndef SESSIONSCHEDULER_H
+#define SESSIONSCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QSet>
+
+class DeviceWindow;
+
+/**
+ * @file sessionscheduler.h
+ * @brief Defines the SessionScheduler class, which runs device bring-ups concurrently.
+ */
+
+/**
+ * @class SessionScheduler
+ * @brief Runs the connection bring-up of many device windows in parallel with a bounded pool.
+ *
+ * Each DeviceWindow performs its own push -> forward -> start -> connect sequence
+ * asynchronously. The scheduler only decides when a window may start it: up to
+ * maxConcurrent bring-ups run at the same time, the rest wait in FIFO order and
+ * are started as soon as a running one succeeds, fails or its window is closed.
+ * Per-stage timings reported by each window are forwarded to the log.
+ */
+class SessionScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a scheduler.
+     * @param maxConcurrent Maximum number of simultaneous bring-ups. 0 selects a default
+     *        based on the number of CPU cores.
+     * @param parent The parent QObject.
+     */
+    explicit SessionScheduler(int maxConcurrent = 0, QObject *parent = nullptr);
+
+    /**
+     * @brief Queues a window for bring-up. Its startStreaming() slot is invoked when a slot is free.
+     * @param window The device window to start.
+     */
+    void enqueue(DeviceWindow *window);
+
+    int maxConcurrent() const { return mMaxConcurrent; }
+    int runningCount() const { return mRunning.size(); }
+    int pendingCount() const { return mPending.size(); }
+
+signals:
+    /**
+     * @brief Emitted to report bring-up results and timings to the UI log.
+     * @param message The log message to be displayed.
+     */
+    void logMessage(const QString &message);
+
+private slots:
+    void onBringUpFinished(const QString &serial, bool success, const QString &stageTimings);
+    void onWindowDestroyed(QObject *window);
+
+private:
+    // Starts queued windows while there are free slots.
+    void dispatch();
+
+    int mMaxConcurrent;
+    QQueue<QPointer<DeviceWindow>> mPending;
+    QSet<QObject*> mRunning;
+};
+
+#endif // SESSIONSCHEDULER_H
@@ -0,0 +1,75 @@
+#include "streamcapture.h"
+#include <QDebug>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QtEndian>
+
+StreamCapture::StreamCapture(const QString &filePath)
+    : m_file(filePath)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "[StreamCapture] Cannot open" << filePath << ":" << m_file.errorString();
+        return;
+    }
+    m_file.write(MAGIC, MAGIC_SIZE);
+    qDebug() << "[StreamCapture] Capturing to" << filePath;
+}
+
+void StreamCapture::write(Channel channel, const char *data, qint64 size)
+{
+    if (size <= 0) return;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen() || m_failed) return;
+
+    // Time is counted from the first byte received, i.e. the video dummy byte
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+
+    uchar header[RECORD_HEADER_SIZE];
+    header[0] = channel;
+    qToBigEndian<quint64>(static_cast<quint64>(m_clock.nsecsElapsed() / 1000), header + 1);
+    qToBigEndian<quint32>(static_cast<quint32>(size), header + 9);
+
+    if (m_file.write(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE
+        || m_file.write(data, size) != size) {
+        qWarning() << "[StreamCapture] Write failed, capture stopped:" << m_file.errorString();
+        m_failed = true;
+    }
+}
+
+QList<StreamCapture::Record> StreamCapture::readAll(QIODevice *device, QString *error)
+{
+    QList<Record> records;
+
+    if (device->read(MAGIC_SIZE) != QByteArray(MAGIC, MAGIC_SIZE)) {
+        *error = QStringLiteral("not a stream capture file");
+        return records;
+    }
+
+    forever {
+        const QByteArray header = device->read(RECORD_HEADER_SIZE);
+        if (header.isEmpty()) {
+            break;
+        }
+
+        const uchar *raw = reinterpret_cast<const uchar*>(header.constData());
+        const quint32 size = (header.size() == RECORD_HEADER_SIZE) ? qFromBigEndian<quint32>(raw + 9) : 0;
+        if (header.size() != RECORD_HEADER_SIZE || raw[0] > AudioChannel || size > MAX_RECORD_SIZE) {
+            *error = QStringLiteral("corrupt record header at offset %1").arg(device->pos() - header.size());
+            break;
+        }
+
+        Record record;
+        record.channel = static_cast<Channel>(raw[0]);
+        record.timestampUs = static_cast<qint64>(qFromBigEndian<quint64>(raw + 1));
+        record.data = device->read(size);
+        if (record.data.size() != static_cast<int>(size)) {
+            *error = QStringLiteral("truncated record at offset %1").arg(device->pos() - record.data.size());
+            break;
+        }
+        records.append(record);
+    }
+    return records;
+}
@@ -0,0 +1,76 @@
+#ifndef STREAMCAPTURE_H
+#define STREAMCAPTURE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+#include <QMutex>
+#include <QElapsedTimer>
+
+class QIODevice;
+
+/**
+ * @file streamcapture.h
+ * @brief Defines the StreamCapture class, which tees the raw socket bytes of a session into a file.
+ */
+
+/**
+ * @class StreamCapture
+ * @brief Writes the exact bytes received on the video and audio sockets to a capture file.
+ *
+ * The bytes are stored as the socket delivered them, including the dummy byte,
+ * device meta, codec headers and packet framing, so a capture can be served
+ * back to the client by tools/scrcpy-replay to reproduce a session without a
+ * device. Each read is stored as one record with its arrival time:
+ *
+ *   file:   "SCRCAP01"
+ *   record: u8 channel, u64 microseconds since the first record, u32 length, bytes
+ *
+ * Integers are big-endian like the scrcpy protocol. write() is thread-safe:
+ * the video and audio decoder threads share one file.
+ */
+class StreamCapture
+{
+public:
+    enum Channel : quint8 {
+        VideoChannel = 0,
+        AudioChannel = 1
+    };
+
+    struct Record {
+        Channel channel = VideoChannel;
+        qint64 timestampUs = 0;
+        QByteArray data;
+    };
+
+    static constexpr char MAGIC[] = "SCRCAP01";
+    static constexpr int MAGIC_SIZE = 8;
+    static constexpr int RECORD_HEADER_SIZE = 13;
+    static constexpr quint32 MAX_RECORD_SIZE = 16 * 1024 * 1024;
+
+    explicit StreamCapture(const QString &filePath);
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_file.fileName(); }
+
+    /**
+     * @brief Appends the bytes of one socket read. Called by the decoder threads.
+     */
+    void write(Channel channel, const char *data, qint64 size);
+
+    /**
+     * @brief Reads a whole capture file (for the replay tool).
+     * @param error Set to a description when the file is missing, not a capture or truncated.
+     * @return The records in file order; the ones before a truncation are kept.
+     */
+    static QList<Record> readAll(QIODevice *device, QString *error);
+
+private:
+    QMutex m_mutex;
+    QFile m_file;
+    QElapsedTimer m_clock;
+    bool m_failed = false;
+};
+
+#endif // STREAMCAPTURE_H
@@ -0,0 +1,360 @@
+#include "streamrecorder.h"
+#include "threadpolicy.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+}
+
+static const AVRational DEVICE_TIME_BASE = {1, 1000000}; // Device timestamps are in microseconds
+
+static QSet<QString> &activePaths()
+{
+    static QSet<QString> paths;
+    return paths;
+}
+
+StreamRecorder::StreamRecorder(const QString &filePath, const QString &format,
+                               bool expectVideo, bool expectAudio, QObject *parent)
+    : QThread(parent), m_filePath(filePath)
+{
+    QString container = format;
+    if (container != "mp4" && container != "mkv") {
+        container = filePath.endsWith(".mp4", Qt::CaseInsensitive) ? "mp4" : "mkv";
+    }
+    m_formatName = (container == "mp4") ? "mp4" : "matroska";
+
+    m_streams[VideoStream].expected = expectVideo;
+    m_streams[AudioStream].expected = expectAudio;
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    finish();
+    wait();
+
+    // Packets never handed to the recorder thread
+    for (QueuedPacket &queued : m_queue) {
+        av_packet_free(&queued.packet);
+    }
+    m_queue.clear();
+}
+
+QString StreamRecorder::reservePath(const QString &requestedPath, const QString &serial)
+{
+    QSet<QString> &active = activePaths();
+    const QFileInfo info(requestedPath);
+    QString candidate = info.absoluteFilePath();
+
+    // The first session writes where the user asked (overwriting was confirmed
+    // in the file dialog); concurrent sessions get their serial appended.
+    if (active.contains(candidate)) {
+        QString safeSerial = serial;
+        safeSerial.replace(QRegularExpression("[^A-Za-z0-9._-]"), "_");
+        const QString base = info.absolutePath() + '/' + info.completeBaseName() + '_' + safeSerial;
+        const QString suffix = info.suffix().isEmpty() ? QString() : '.' + info.suffix();
+
+        candidate = base + suffix;
+        for (int i = 2; active.contains(candidate) || QFile::exists(candidate); ++i) {
+            candidate = QString("%1_%2%3").arg(base).arg(i).arg(suffix);
+        }
+    }
+
+    active.insert(candidate);
+    return candidate;
+}
+
+QString StreamRecorder::reserveSegmentPath(const QString &firstPath, int segment)
+{
+    QSet<QString> &active = activePaths();
+    const QFileInfo info(firstPath);
+    const QString base = info.absolutePath() + '/' + info.completeBaseName() + '_' + QString::number(segment);
+    const QString suffix = info.suffix().isEmpty() ? QString() : '.' + info.suffix();
+
+    QString candidate = base + suffix;
+    for (int i = 2; active.contains(candidate) || QFile::exists(candidate); ++i) {
+        candidate = QString("%1_%2%3").arg(base).arg(i).arg(suffix);
+    }
+
+    active.insert(candidate);
+    return candidate;
+}
+
+void StreamRecorder::releasePath(const QString &path)
+{
+    activePaths().remove(path);
+}
+
+void StreamRecorder::setStreamCodec(Stream stream, int codecId, const QSize &videoSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streams[stream].codecId = codecId;
+    m_streams[stream].videoSize = videoSize;
+    m_condition.wakeOne();
+}
+
+void StreamRecorder::setExtradata(Stream stream, const QByteArray &extradata)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streams[stream].extradata = extradata;
+    m_condition.wakeOne();
+}
+
+void StreamRecorder::disableStream(Stream stream)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streams[stream].disabled = true;
+    m_condition.wakeOne();
+}
+
+void StreamRecorder::pushPacket(Stream stream, const AVPacket *packet)
+{
+    // A reference: refcounted payloads (the pooled video slabs) are shared, not copied
+    AVPacket *ref = av_packet_alloc();
+    if (!ref || av_packet_ref(ref, packet) < 0) {
+        av_packet_free(&ref);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_finishing || m_queue.size() >= MAX_QUEUED_PACKETS) {
+        if (!m_finishing && m_droppedPackets++ == 0) {
+            qWarning() << "[StreamRecorder] Disk is not keeping up, dropping packets";
+        }
+        locker.unlock();
+        av_packet_free(&ref);
+        return;
+    }
+    m_queue.append({stream, ref});
+    m_condition.wakeOne();
+}
+
+void StreamRecorder::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    m_finishing = true;
+    m_condition.wakeOne();
+}
+
+bool StreamRecorder::isReadyLocked() const
+{
+    for (const StreamInfo &info : m_streams) {
+        if (!info.expected || info.disabled) {
+            continue;
+        }
+        if (info.codecId == AV_CODEC_ID_NONE) {
+            return false;
+        }
+        // Raw PCM has no config packet; every other codec needs one for the header
+        if (info.extradata.isEmpty() && info.codecId != AV_CODEC_ID_PCM_S16LE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamRecorder::run()
+{
+    qDebug() << "[StreamRecorder] Recording to" << m_filePath;
+    ThreadPolicy::instance().applyToCurrentThread(ThreadPolicy::Recording);
+
+    forever {
+        QList<QueuedPacket> batch;
+        StreamInfo streams[STREAM_COUNT];
+        bool ready = false;
+        bool finishing = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_finishing) {
+                m_condition.wait(&m_mutex);
+            }
+            batch.swap(m_queue);
+            finishing = m_finishing;
+            if (!m_headerWritten) {
+                ready = isReadyLocked();
+                for (int i = 0; i < STREAM_COUNT; ++i) {
+                    streams[i] = m_streams[i];
+                }
+            }
+        }
+
+        for (QueuedPacket &queued : batch) {
+            if (m_headerWritten) {
+                writePacket(queued);
+            } else if (m_failed) {
+                av_packet_free(&queued.packet);
+            } else {
+                m_pending.append(queued);
+            }
+        }
+
+        if (!m_headerWritten && !m_failed && !m_pending.isEmpty()
+            && (ready || finishing || m_pending.size() >= MAX_PENDING_PACKETS)) {
+            if (!ready) {
+                qWarning() << "[StreamRecorder] Not every stream announced its codec, recording the others";
+            }
+            m_headerWritten = writeHeader(streams);
+            m_failed = !m_headerWritten;
+
+            // The file starts at the earliest buffered packet of a recorded stream
+            for (const QueuedPacket &queued : std::as_const(m_pending)) {
+                if (m_avStreams[queued.stream] && queued.packet->pts != AV_NOPTS_VALUE
+                    && (m_ptsOrigin < 0 || queued.packet->pts < m_ptsOrigin)) {
+                    m_ptsOrigin = queued.packet->pts;
+                }
+            }
+            for (QueuedPacket &queued : m_pending) {
+                if (m_headerWritten) {
+                    writePacket(queued);
+                } else {
+                    av_packet_free(&queued.packet);
+                }
+            }
+            m_pending.clear();
+        }
+
+        if (finishing) {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                break;
+            }
+        }
+    }
+
+    for (QueuedPacket &queued : m_pending) {
+        av_packet_free(&queued.packet);
+    }
+    m_pending.clear();
+    closeFile();
+    ThreadPolicy::instance().releaseCurrentThread();
+    emit recordingFinished(m_filePath, m_headerWritten && !m_failed);
+}
+
+bool StreamRecorder::writeHeader(const StreamInfo (&streams)[STREAM_COUNT])
+{
+    const QByteArray path = QFile::encodeName(m_filePath);
+    if (avformat_alloc_output_context2(&m_formatContext, nullptr,
+                                       m_formatName.toLatin1().constData(), path.constData()) < 0) {
+        qWarning() << "[StreamRecorder] Unsupported container" << m_formatName;
+        return false;
+    }
+
+    for (int i = 0; i < STREAM_COUNT; ++i) {
+        const StreamInfo &info = streams[i];
+        if (!info.expected || info.disabled || info.codecId == AV_CODEC_ID_NONE
+            || (info.extradata.isEmpty() && info.codecId != AV_CODEC_ID_PCM_S16LE)) {
+            continue;
+        }
+
+        AVStream *stream = avformat_new_stream(m_formatContext, nullptr);
+        if (!stream) {
+            return false;
+        }
+
+        AVCodecParameters *par = stream->codecpar;
+        par->codec_id = static_cast<AVCodecID>(info.codecId);
+        if (i == VideoStream) {
+            par->codec_type = AVMEDIA_TYPE_VIDEO;
+            par->width = info.videoSize.width();
+            par->height = info.videoSize.height();
+        } else {
+            // scrcpy always captures 48 kHz stereo
+            par->codec_type = AVMEDIA_TYPE_AUDIO;
+            par->sample_rate = 48000;
+            av_channel_layout_default(&par->ch_layout, 2);
+            if (par->codec_id == AV_CODEC_ID_PCM_S16LE) {
+                par->format = AV_SAMPLE_FMT_S16;
+            }
+        }
+
+        if (!info.extradata.isEmpty()) {
+            par->extradata = static_cast<uint8_t*>(
+                av_mallocz(static_cast<size_t>(info.extradata.size()) + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (!par->extradata) {
+                return false;
+            }
+            memcpy(par->extradata, info.extradata.constData(), static_cast<size_t>(info.extradata.size()));
+            par->extradata_size = info.extradata.size();
+        }
+
+        stream->time_base = DEVICE_TIME_BASE;
+        m_avStreams[i] = stream;
+    }
+
+    if (m_formatContext->nb_streams == 0) {
+        qWarning() << "[StreamRecorder] Nothing to record";
+        return false;
+    }
+
+    if (avio_open(&m_formatContext->pb, path.constData(), AVIO_FLAG_WRITE) < 0) {
+        qWarning() << "[StreamRecorder] Cannot open" << m_filePath;
+        return false;
+    }
+
+    if (avformat_write_header(m_formatContext, nullptr) < 0) {
+        qWarning() << "[StreamRecorder] Failed to write the header of" << m_filePath;
+        return false;
+    }
+    return true;
+}
+
+void StreamRecorder::writePacket(QueuedPacket &queued)
+{
+    AVStream *stream = m_avStreams[queued.stream];
+    AVPacket *packet = queued.packet;
+
+    if (!stream || packet->pts == AV_NOPTS_VALUE || packet->pts < m_ptsOrigin) {
+        av_packet_free(&queued.packet);
+        return;
+    }
+
+    packet->pts -= m_ptsOrigin;
+    packet->dts = packet->pts;
+    packet->stream_index = stream->index;
+    if (queued.stream == AudioStream) {
+        packet->flags |= AV_PKT_FLAG_KEY;
+    }
+    av_packet_rescale_ts(packet, DEVICE_TIME_BASE, stream->time_base);
+
+    if (av_interleaved_write_frame(m_formatContext, packet) < 0) {
+        if (!m_failed) {
+            qWarning() << "[StreamRecorder] Write error on" << m_filePath;
+        }
+        m_failed = true;
+    } else {
+        m_writtenPackets++;
+    }
+    av_packet_free(&queued.packet);
+}
+
+void StreamRecorder::closeFile()
+{
+    if (!m_formatContext) {
+        qWarning() << "[StreamRecorder] No recording was written to" << m_filePath;
+        return;
+    }
+
+    if (m_headerWritten) {
+        av_write_trailer(m_formatContext);
+    }
+    if (m_formatContext->pb) {
+        avio_closep(&m_formatContext->pb);
+    }
+    avformat_free_context(m_formatContext);
+    m_formatContext = nullptr;
+
+    if (m_headerWritten) {
+        qInfo() << "[StreamRecorder] Recording saved to" << m_filePath << "-" << m_writtenPackets << "packets";
+        if (m_droppedPackets > 0) {
+            qWarning() << "[StreamRecorder]" << m_droppedPackets << "packets were dropped";
+        }
+    }
+}
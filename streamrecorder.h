@@ -0,0 +1,155 @@
+#ifndef STREAMRECORDER_H
+#define STREAMRECORDER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QSize>
+#include <QList>
+
+// Forward declarations
+struct AVPacket;
+struct AVFormatContext;
+struct AVStream;
+
+/**
+ * @file streamrecorder.h
+ * @brief Defines the StreamRecorder class, which records the received streams on the host.
+ */
+
+/**
+ * @class StreamRecorder
+ * @brief Muxes the received video and audio packets into an mkv/mp4 file on a background thread.
+ *
+ * Packets are written as they came from the device, without re-encoding.
+ * The decoder threads hand over packets with pushPacket(), which only takes
+ * a reference (the pooled video payload is not copied). The file header is
+ * written once every expected stream has announced its codec and config
+ * (codec parameter sets / audio setup data), as the reference client does.
+ * Timestamps are device microseconds and are shifted so the file starts at 0.
+ *
+ * pushPacket(), setExtradata() and the stream setters are thread-safe.
+ * finish() completes the file asynchronously and recordingFinished() reports
+ * the result; the destructor waits for it.
+ */
+class StreamRecorder : public QThread
+{
+    Q_OBJECT
+public:
+    enum Stream {
+        VideoStream = 0,
+        AudioStream = 1,
+        STREAM_COUNT
+    };
+
+    /**
+     * @param filePath The output file.
+     * @param format "mp4", "mkv" or "auto" (chosen from the file extension).
+     * @param expectVideo, expectAudio The streams the header waits for.
+     */
+    StreamRecorder(const QString &filePath, const QString &format,
+                   bool expectVideo, bool expectAudio, QObject *parent = nullptr);
+    ~StreamRecorder();
+
+    /**
+     * @brief Reserves an output path not used by another session or an existing file.
+     *
+     * Several devices recording with the same options would otherwise write
+     * to one file; later sessions get "_<serial>" (and a counter if needed)
+     * inserted before the extension. GUI thread only.
+     */
+    static QString reservePath(const QString &requestedPath, const QString &serial);
+
+    /**
+     * @brief Reserves the path of segment @p segment (2 and up) of a recording that started at @p firstPath.
+     *
+     * Segments are named "<base>_<segment>" before the extension. Unlike the
+     * first path, which the user chose, an existing file is never overwritten:
+     * a counter is appended until the name is free. GUI thread only.
+     */
+    static QString reserveSegmentPath(const QString &firstPath, int segment);
+    static void releasePath(const QString &path);
+
+    QString filePath() const { return m_filePath; }
+
+    /**
+     * @brief Declares a stream's codec (an AVCodecID) and, for video, its size.
+     */
+    void setStreamCodec(Stream stream, int codecId, const QSize &videoSize = QSize());
+
+    /**
+     * @brief Sets a stream's codec configuration (the config packet). Ignored once the header is written.
+     */
+    void setExtradata(Stream stream, const QByteArray &extradata);
+
+    /**
+     * @brief Removes a stream the header would otherwise wait for (e.g. audio disabled on the device).
+     */
+    void disableStream(Stream stream);
+
+    /**
+     * @brief Queues a media packet for writing. Refcounted payloads are referenced, others copied.
+     */
+    void pushPacket(Stream stream, const AVPacket *packet);
+
+    /**
+     * @brief Writes the remaining packets and the trailer, then ends the thread.
+     */
+    void finish();
+
+signals:
+    /**
+     * @brief Emitted from the recorder thread once the file is closed.
+     * @param success False if nothing could be written or a write failed.
+     */
+    void recordingFinished(const QString &filePath, bool success);
+
+protected:
+    void run() override;
+
+private:
+    struct StreamInfo {
+        bool expected = false;
+        bool disabled = false;
+        int codecId = 0;             // AV_CODEC_ID_NONE
+        QSize videoSize;
+        QByteArray extradata;
+    };
+
+    struct QueuedPacket {
+        Stream stream;
+        AVPacket *packet;
+    };
+
+    bool isReadyLocked() const;
+    bool writeHeader(const StreamInfo (&streams)[STREAM_COUNT]);
+    void writePacket(QueuedPacket &queued);
+    void closeFile();
+
+    // Before the header is written, packets wait here (bounded): if a stream
+    // never becomes ready, the header is written with the streams that are.
+    static constexpr int MAX_PENDING_PACKETS = 1000;
+    static constexpr int MAX_QUEUED_PACKETS = 4000;
+
+    QString m_filePath;
+    QString m_formatName;
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    StreamInfo m_streams[STREAM_COUNT];
+    QList<QueuedPacket> m_queue;
+    bool m_finishing = false;
+    quint64 m_droppedPackets = 0;
+
+    // Recorder thread only
+    QList<QueuedPacket> m_pending;
+    AVFormatContext *m_formatContext = nullptr;
+    AVStream *m_avStreams[STREAM_COUNT] = {nullptr, nullptr};
+    qint64 m_ptsOrigin = -1;
+    bool m_headerWritten = false;
+    bool m_failed = false;
+    quint64 m_writtenPackets = 0;
+};
+
+#endif // STREAMRECORDER_H
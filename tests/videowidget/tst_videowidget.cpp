@@ -0,0 +1,86 @@
+#include <QtTest>
+#include <QPaintEvent>
+#include "videowidget.h"
+
+// Records the region of every paint; run with QT_QPA_PLATFORM=offscreen
+class RecordingVideoWidget : public VideoWidget
+{
+public:
+    QList<QRegion> paintedRegions;
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        paintedRegions.append(event->region());
+        VideoWidget::paintEvent(event);
+    }
+};
+
+class TestVideoWidget : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fullFrameAfterPartialFrameRepaintsWholeFrame();
+    void partialFramesRepaintOnlyTheirRegions();
+
+private:
+    static QImage frame(const QColor &color);
+    static void showAndPaint(RecordingVideoWidget &widget);
+};
+
+QImage TestVideoWidget::frame(const QColor &color)
+{
+    QImage image(320, 640, QImage::Format_RGB32);
+    image.fill(color);
+    return image;
+}
+
+void TestVideoWidget::showAndPaint(RecordingVideoWidget &widget)
+{
+    widget.resize(320, 640);
+    widget.setFrame(frame(Qt::black));
+    widget.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&widget));
+    QTRY_VERIFY(!widget.isFramePending());
+    widget.paintedRegions.clear();
+}
+
+void TestVideoWidget::fullFrameAfterPartialFrameRepaintsWholeFrame()
+{
+    RecordingVideoWidget widget;
+    showAndPaint(widget);
+
+    // Both arrive before the next paint: the second one changes the whole frame
+    widget.setFrame(frame(Qt::black), QRegion(0, 0, 16, 16));
+    widget.setFrame(frame(Qt::white));
+
+    QTRY_VERIFY(!widget.isFramePending());
+    QCOMPARE(widget.coalescedFrames(), quint64(1));
+    QRegion painted;
+    for (const QRegion &region : std::as_const(widget.paintedRegions)) {
+        painted += region;
+    }
+    QCOMPARE(painted.intersected(widget.videoRect()), QRegion(widget.videoRect()));
+}
+
+void TestVideoWidget::partialFramesRepaintOnlyTheirRegions()
+{
+    RecordingVideoWidget widget;
+    showAndPaint(widget);
+
+    widget.setFrame(frame(Qt::black), QRegion(0, 0, 16, 16));
+    widget.setFrame(frame(Qt::black), QRegion(0, 320, 16, 16));
+
+    QTRY_VERIFY(!widget.isFramePending());
+    QRegion painted;
+    for (const QRegion &region : std::as_const(widget.paintedRegions)) {
+        painted += region;
+    }
+    QVERIFY(painted.contains(QPoint(8, 8)));
+    QVERIFY(painted.contains(QPoint(8, 328)));
+    QVERIFY(!painted.contains(QPoint(160, 160)));
+}
+
+QTEST_MAIN(TestVideoWidget)
+#include "tst_videowidget.moc"
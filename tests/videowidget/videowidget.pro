@@ -0,0 +1,16 @@
+QT       = core gui widgets testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_videowidget
+
+ROOT_PATH = $$PWD/../..
+INCLUDEPATH += $$ROOT_PATH
+
+SOURCES += \
+    $$ROOT_PATH/videowidget.cpp \
+    tst_videowidget.cpp
+
+HEADERS += \
+    $$ROOT_PATH/videowidget.h
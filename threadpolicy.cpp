@@ -0,0 +1,443 @@
+#include "threadpolicy.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+/**
+ * @brief Normal-priority thread that notices when real-time threads keep it off the CPU.
+ *
+ * It sleeps for short periods; waking up much later than asked means the
+ * time-sharing threads, the GUI among them, are being starved.
+ */
+class RealtimeWatchdog : public QThread
+{
+public:
+    RealtimeWatchdog(int periodMs, int stallMs) : mPeriodMs(periodMs), mStallMs(stallMs) {}
+
+protected:
+    void run() override
+    {
+        // Started by the first real-time thread, whose class it would otherwise inherit
+        ThreadPolicy::instance().resetCurrentThread();
+
+        QElapsedTimer timer;
+        while (!isInterruptionRequested()) {
+            timer.start();
+            msleep(mPeriodMs);
+            const qint64 lateMs = timer.elapsed() - mPeriodMs;
+            if (lateMs >= mStallMs) {
+                ThreadPolicy::instance().demoteRealtimeThreads(lateMs);
+            }
+        }
+    }
+
+private:
+    const int mPeriodMs;
+    const int mStallMs;
+};
+
+namespace {
+
+#ifdef Q_OS_UNIX
+QString errorText(int error)
+{
+    return QString::fromLocal8Bit(strerror(error));
+}
+#endif
+
+QString cpuListText(const QList<int> &cpus)
+{
+    QStringList parts;
+    for (int i = 0; i < cpus.size(); ++i) {
+        int last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) {
+            last++;
+        }
+        parts.append(last > i ? QString("%1-%2").arg(cpus[i]).arg(cpus[last]) : QString::number(cpus[i]));
+        i = last;
+    }
+    return parts.join(',');
+}
+
+bool parseCpuList(const QString &text, QList<int> *cpus)
+{
+    QList<int> result;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList bounds = part.split('-');
+        bool firstOk = false;
+        bool lastOk = false;
+        const int first = bounds.value(0).trimmed().toInt(&firstOk);
+        const int last = (bounds.size() == 2) ? bounds[1].trimmed().toInt(&lastOk) : first;
+        if (!firstOk || (bounds.size() == 2 && !lastOk) || bounds.size() > 2
+            || first < 0 || last < first || last >= 1024) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (!result.contains(cpu)) {
+                result.append(cpu);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    *cpus = result;
+    return !result.isEmpty();
+}
+
+} // namespace
+
+ThreadPolicy &ThreadPolicy::instance()
+{
+    static ThreadPolicy policy;
+    return policy;
+}
+
+ThreadPolicy::ThreadPolicy()
+{
+    // Slightly ahead of the GUI and everything else in the process, as the
+    // decoders always were on Windows; real-time classes only on request
+    mPolicies[VideoDecode].niceness = -5;
+    mPolicies[AudioDecode].niceness = -5;
+}
+
+ThreadPolicy::~ThreadPolicy()
+{
+    if (mWatchdog) {
+        mWatchdog->requestInterruption();
+        mWatchdog->wait();
+        delete mWatchdog;
+    }
+}
+
+QString ThreadPolicy::roleName(Role role)
+{
+    switch (role) {
+    case VideoDecode: return "video";
+    case AudioDecode: return "audio";
+    case Recording:   return "recording";
+    default:          return QString();
+    }
+}
+
+bool ThreadPolicy::parse(const QString &spec, QString *error)
+{
+    RolePolicy parsed[ROLE_COUNT];
+    bool named[ROLE_COUNT] = {};
+    {
+        QMutexLocker locker(&mMutex);
+        for (int role = 0; role < ROLE_COUNT; ++role) {
+            parsed[role] = mPolicies[role];
+        }
+    }
+
+    for (const QString &entry : spec.split(';', Qt::SkipEmptyParts)) {
+        const QStringList fields = entry.trimmed().split(':');
+        int role = 0;
+        while (role < ROLE_COUNT && roleName(static_cast<Role>(role)) != fields.first().trimmed()) {
+            role++;
+        }
+        if (role == ROLE_COUNT) {
+            *error = QString("unknown thread role \"%1\"").arg(fields.first());
+            return false;
+        }
+
+        // Settings not named keep their current value
+        RolePolicy &policy = parsed[role];
+        named[role] = true;
+        for (int i = 1; i < fields.size(); ++i) {
+            const QString key = fields[i].section('=', 0, 0).trimmed();
+            const QString value = fields[i].section('=', 1).trimmed();
+            bool ok = true;
+            if (key == "nice") {
+                policy.niceness = value.toInt(&ok);
+                ok = ok && policy.niceness >= -20 && policy.niceness <= 19;
+            } else if (key == "sched") {
+                if (value == "other") {
+                    policy.scheduler = TimeSharing;
+                } else if (value == "fifo") {
+                    policy.scheduler = Fifo;
+                } else if (value == "rr") {
+                    policy.scheduler = RoundRobin;
+                } else {
+                    ok = false;
+                }
+            } else if (key == "priority") {
+                policy.realtimePriority = value.toInt(&ok);
+                ok = ok && policy.realtimePriority >= 1 && policy.realtimePriority <= 99;
+            } else if (key == "cpus") {
+                ok = parseCpuList(value, &policy.cpus);
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                *error = QString("invalid setting \"%1\" for %2").arg(fields[i], roleName(static_cast<Role>(role)));
+                return false;
+            }
+        }
+    }
+
+    QMutexLocker locker(&mMutex);
+    for (int role = 0; role < ROLE_COUNT; ++role) {
+        if (named[role]) {
+            mPolicies[role] = parsed[role];
+            mUserSet[role] = true;
+        }
+    }
+    return true;
+}
+
+void ThreadPolicy::setPolicy(Role role, const RolePolicy &policy)
+{
+    QMutexLocker locker(&mMutex);
+    mPolicies[role] = policy;
+    mUserSet[role] = true;
+}
+
+ThreadPolicy::RolePolicy ThreadPolicy::policy(Role role) const
+{
+    QMutexLocker locker(&mMutex);
+    return mPolicies[role];
+}
+
+QString ThreadPolicy::applyToCurrentThread(Role role)
+{
+    RolePolicy requested;
+    bool userSet = false;
+    {
+        QMutexLocker locker(&mMutex);
+        requested = mPolicies[role];
+        userSet = mUserSet[role];
+    }
+    QStringList applied;
+    QStringList refused;
+
+    // Real-time class first: with it, the niceness no longer matters
+    bool realtime = false;
+    if (requested.scheduler != TimeSharing) {
+        const QString name = QString("%1 %2")
+            .arg(requested.scheduler == Fifo ? "SCHED_FIFO" : "SCHED_RR")
+            .arg(requested.realtimePriority);
+        QMutexLocker locker(&mMutex);
+        if (mRealtimeDisabled) {
+            refused.append(name + " (disabled by the watchdog)");
+        } else {
+#ifdef Q_OS_WIN
+            // No watchdog needed: Windows boosts starved threads on its own
+            if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+                applied.append("THREAD_PRIORITY_HIGHEST");
+                realtime = true;
+            } else {
+                refused.append("THREAD_PRIORITY_HIGHEST");
+            }
+#elif defined(Q_OS_UNIX)
+            sched_param param;
+            memset(&param, 0, sizeof(param));
+            const int schedPolicy = (requested.scheduler == Fifo) ? SCHED_FIFO : SCHED_RR;
+            param.sched_priority = qBound(sched_get_priority_min(schedPolicy), requested.realtimePriority,
+                                          sched_get_priority_max(schedPolicy));
+            const int result = pthread_setschedparam(pthread_self(), schedPolicy, &param);
+            if (result == 0) {
+                applied.append(name);
+                realtime = true;
+                mRealtimeThreads.append(QThread::currentThreadId());
+                if (!mWatchdog) {
+                    mWatchdog = new RealtimeWatchdog(WATCHDOG_PERIOD_MS, WATCHDOG_STALL_MS);
+                    mWatchdog->start();
+                }
+            } else {
+                refused.append(QString("%1 (%2)").arg(name, errorText(result)));
+            }
+#else
+            refused.append(name + " (not supported)");
+#endif
+        }
+    }
+
+    if (requested.niceness != 0 && !realtime) {
+        const QString name = QString("nice %1").arg(requested.niceness);
+#ifdef Q_OS_WIN
+        int priority = THREAD_PRIORITY_NORMAL;
+        if (requested.niceness <= -10) {
+            priority = THREAD_PRIORITY_HIGHEST;
+        } else if (requested.niceness < 0) {
+            priority = THREAD_PRIORITY_ABOVE_NORMAL;
+        } else if (requested.niceness < 10) {
+            priority = THREAD_PRIORITY_BELOW_NORMAL;
+        } else {
+            priority = THREAD_PRIORITY_LOWEST;
+        }
+        if (SetThreadPriority(GetCurrentThread(), priority)) {
+            applied.append(name);
+        } else {
+            refused.append(name);
+        }
+#elif defined(Q_OS_LINUX)
+        // On Linux the niceness is per thread, addressed by its kernel thread id
+        const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, requested.niceness) == 0) {
+            applied.append(name);
+        } else {
+            refused.append(QString("%1 (%2, see RLIMIT_NICE)").arg(name, errorText(errno)));
+        }
+#else
+        refused.append(name + " (not supported)");
+#endif
+    }
+
+    if (!requested.cpus.isEmpty()) {
+        const QString name = QString("cpus %1").arg(cpuListText(requested.cpus));
+#ifdef Q_OS_WIN
+        DWORD_PTR mask = 0;
+        for (int cpu : requested.cpus) {
+            if (cpu < int(sizeof(DWORD_PTR) * 8)) {
+                mask |= DWORD_PTR(1) << cpu;
+            }
+        }
+        if (mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0) {
+            applied.append(name);
+        } else {
+            refused.append(name);
+        }
+#elif defined(Q_OS_LINUX)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : requested.cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (result == 0) {
+            applied.append(name);
+        } else {
+            refused.append(QString("%1 (%2)").arg(name, errorText(result)));
+        }
+#else
+        refused.append(name + " (not supported)");
+#endif
+    }
+
+    QString summary = QString("%1 thread: %2").arg(roleName(role),
+        applied.isEmpty() ? QString("default scheduling") : applied.join(", "));
+    if (!refused.isEmpty()) {
+        summary += QString("; refused %1").arg(refused.join(", "));
+    }
+    // Unprivileged users get the built-in niceness refused; only what was asked for is worth a warning
+    if (!refused.isEmpty() && userSet) {
+        qWarning().noquote() << "[ThreadPolicy]" << summary;
+    } else {
+        qDebug().noquote() << "[ThreadPolicy]" << summary;
+    }
+    return summary;
+}
+
+void ThreadPolicy::releaseCurrentThread()
+{
+    RealtimeWatchdog *idleWatchdog = nullptr;
+    {
+        QMutexLocker locker(&mMutex);
+        mRealtimeThreads.removeAll(QThread::currentThreadId());
+        if (mRealtimeThreads.isEmpty()) {
+            std::swap(idleWatchdog, mWatchdog);
+        }
+    }
+
+    // Stopped outside the lock, which the watchdog takes to demote threads
+    if (idleWatchdog) {
+        idleWatchdog->requestInterruption();
+        idleWatchdog->wait();
+        delete idleWatchdog;
+    }
+}
+
+void ThreadPolicy::resetCurrentThread()
+{
+    QStringList refused;
+#ifdef Q_OS_WIN
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL)) {
+        refused.append("THREAD_PRIORITY_NORMAL");
+    }
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)
+        || SetThreadAffinityMask(GetCurrentThread(), processMask) == 0) {
+        refused.append("process affinity");
+    }
+#elif defined(Q_OS_UNIX)
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    const int result = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    if (result != 0) {
+        refused.append(QString("SCHED_OTHER (%1)").arg(errorText(result)));
+    }
+#ifdef Q_OS_LINUX
+    const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, 0) != 0) {
+        refused.append(QString("nice 0 (%1)").arg(errorText(errno)));
+    }
+    // The main thread's mask is the process's: policies are never applied to it
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(getpid(), sizeof(set), &set) != 0
+        || sched_setaffinity(0, sizeof(set), &set) != 0) {
+        refused.append(QString("process affinity (%1)").arg(errorText(errno)));
+    }
+#endif
+#endif
+    if (!refused.isEmpty()) {
+        qDebug().noquote() << "[ThreadPolicy] Could not reset thread: refused" << refused.join(", ");
+    }
+}
+
+void ThreadPolicy::demoteRealtimeThreads(qint64 stallMs)
+{
+    QMutexLocker locker(&mMutex);
+    if (mRealtimeThreads.isEmpty()) {
+        return;
+    }
+
+    int demoted = 0;
+#ifdef Q_OS_UNIX
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+#ifdef Q_OS_LINUX
+    // Threads started by real-time threads, libavcodec's workers among them,
+    // inherit the class without registering here: check every thread
+    const QStringList tasks = QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &task : tasks) {
+        const pid_t tid = static_cast<pid_t>(task.toInt());
+        const int schedPolicy = sched_getscheduler(tid);
+        if ((schedPolicy == SCHED_FIFO || schedPolicy == SCHED_RR)
+            && sched_setscheduler(tid, SCHED_OTHER, &param) == 0) {
+            demoted++;
+        }
+    }
+#else
+    for (Qt::HANDLE handle : std::as_const(mRealtimeThreads)) {
+        if (pthread_setschedparam(reinterpret_cast<pthread_t>(handle), SCHED_OTHER, &param) == 0) {
+            demoted++;
+        }
+    }
+#endif
+#endif
+    qWarning() << "[ThreadPolicy] Normal threads were held off for" << stallMs << "ms,"
+               << "demoted" << demoted << "real-time thread(s) for the rest of the session";
+    mRealtimeThreads.clear();
+    mRealtimeDisabled = true;
+}
@@ -0,0 +1,120 @@
+#ifndef THREADPOLICY_H
+#define THREADPOLICY_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @file threadpolicy.h
+ * @brief Defines the ThreadPolicy class, the scheduling priority and CPU affinity of the worker threads.
+ */
+
+class RealtimeWatchdog;
+
+/**
+ * @class ThreadPolicy
+ * @brief Applies a per-role scheduling policy (niceness, real-time class, CPU affinity) to worker threads.
+ *
+ * Each long-running thread calls applyToCurrentThread() with its role when it
+ * starts, and releaseCurrentThread() before it exits. What the OS actually
+ * granted is logged and returned; a denied setting (e.g. a negative niceness
+ * without CAP_SYS_NICE or RLIMIT_NICE on Linux) leaves the thread as it was.
+ * Refusals are warnings for policies set by the user, and debug messages for
+ * the built-in defaults, which most Linux users are not allowed to raise.
+ *
+ * SCHED_FIFO and SCHED_RR are only used when asked for. While a thread holds
+ * one, a watchdog at normal priority checks that it still gets the CPU on
+ * time; if it is held off for WATCHDOG_STALL_MS, every real-time thread of
+ * the process is demoted to normal scheduling for the rest of the session,
+ * so a runaway decoder cannot starve the GUI. That includes threads which
+ * inherited the class without registering, such as libavcodec's workers.
+ *
+ * Threads started from a configured thread inherit its scheduling and
+ * affinity. Helpers that should not, like the frame conversion pool, call
+ * resetCurrentThread() when they start.
+ *
+ * Niceness and affinity are per thread on Linux and Windows (where niceness
+ * maps to the thread priority levels); other platforms report them as
+ * unsupported. The policy is process-wide and thread-safe.
+ */
+class ThreadPolicy
+{
+public:
+    enum Role {
+        VideoDecode,
+        AudioDecode,
+        Recording,
+        ROLE_COUNT
+    };
+
+    enum Scheduler {
+        TimeSharing,    // SCHED_OTHER
+        Fifo,           // SCHED_FIFO
+        RoundRobin      // SCHED_RR
+    };
+
+    struct RolePolicy
+    {
+        int niceness = 0;           // -20 (highest) to 19; 0 leaves the thread's priority alone
+        Scheduler scheduler = TimeSharing;
+        int realtimePriority = 1;   // 1 to 99, for Fifo and RoundRobin
+        QList<int> cpus;            // CPUs the thread may run on; empty for any
+    };
+
+    static ThreadPolicy &instance();
+
+    /**
+     * @brief Sets policies from a command-line spec, e.g. "video:nice=-5:cpus=2-7;audio:sched=rr:priority=10".
+     *
+     * Roles are "video", "audio" and "recording", each followed by ':'-separated
+     * settings: nice=<n>, sched=other|fifo|rr, priority=<1-99> and cpus=<list>,
+     * where the list takes single CPUs and ranges, e.g. "0,2-5". Roles that are
+     * not named, and settings not given, keep their current value.
+     * @return False, with @p error set, if the spec is malformed; nothing is changed then.
+     */
+    bool parse(const QString &spec, QString *error);
+
+    void setPolicy(Role role, const RolePolicy &policy);
+    RolePolicy policy(Role role) const;
+
+    /**
+     * @brief Applies the role's policy to the calling thread.
+     * @return A summary of what was applied and what was refused, which is also logged.
+     */
+    QString applyToCurrentThread(Role role);
+
+    /**
+     * @brief Forgets the calling thread; call before a thread set up with applyToCurrentThread() exits.
+     */
+    void releaseCurrentThread();
+
+    /**
+     * @brief Returns the calling thread to normal scheduling, niceness 0 and the process's CPU affinity.
+     *
+     * Only ever lowers the priority, so it needs no privileges.
+     */
+    void resetCurrentThread();
+
+    static QString roleName(Role role);
+
+private:
+    ThreadPolicy();
+    ~ThreadPolicy();
+    Q_DISABLE_COPY(ThreadPolicy)
+
+    friend class RealtimeWatchdog;
+    void demoteRealtimeThreads(qint64 stallMs);
+
+    static constexpr int WATCHDOG_PERIOD_MS = 100;
+    static constexpr int WATCHDOG_STALL_MS = 500;
+
+    mutable QMutex mMutex;
+    RolePolicy mPolicies[ROLE_COUNT];
+    bool mUserSet[ROLE_COUNT] = {};   // Set by parse() or setPolicy(), not the built-in default
+    QList<Qt::HANDLE> mRealtimeThreads;
+    bool mRealtimeDisabled = false;   // Set once the watchdog had to step in
+    RealtimeWatchdog *mWatchdog = nullptr;
+};
+
+#endif // THREADPOLICY_H
@@ -0,0 +1,98 @@
+#include "generatorserver.h"
+#include "syntheticstream.h"
+#include <QDebug>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+GeneratorServer::GeneratorServer(const SyntheticStream *stream, const QString &deviceName, QObject *parent)
+    : QObject(parent), m_stream(stream), m_deviceName(deviceName)
+{
+    // Ticks at the frame interval; sendDueFrames() catches up from the clock,
+    // so timer jitter does not change the average frame rate
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(qMax(1, 1000 / stream->settings().fps));
+    connect(&m_timer, &QTimer::timeout, this, &GeneratorServer::sendDueFrames);
+    connect(&m_server, &QTcpServer::newConnection, this, &GeneratorServer::onNewConnection);
+}
+
+bool GeneratorServer::listen(quint16 port)
+{
+    if (!m_server.listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "[GeneratorServer]" << m_deviceName << "cannot listen on port" << port
+                   << ":" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void GeneratorServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        socket->setParent(this);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        // Same order as the scrcpy server: video, audio, control
+        if (!m_videoSocket) {
+            m_videoSocket = socket;
+            connect(socket, &QTcpSocket::disconnected, this, [this]() {
+                qDebug() << "[GeneratorServer]" << m_deviceName << "client disconnected";
+                resetSession();
+            });
+            const QByteArray preamble = m_stream->preamble(m_deviceName);
+            socket->write(preamble);
+            m_sentBytes += preamble.size();
+            m_nextFrame = 0;
+            m_waitingForKeyFrame = false;
+            m_clock.start();
+            m_timer.start();
+        } else if (!m_audioSocket) {
+            // Without audio enabled the client ignores this on its control socket
+            m_audioSocket = socket;
+            socket->write(QByteArray(4, '\0')); // Codec id 0: audio disabled on the device
+            connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->readAll(); });
+        } else if (!m_controlSocket) {
+            m_controlSocket = socket;
+            connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->readAll(); });
+        } else {
+            socket->abort();
+            socket->deleteLater();
+        }
+    }
+}
+
+void GeneratorServer::sendDueFrames()
+{
+    if (!m_videoSocket) return;
+
+    const qint64 dueFrames = m_clock.elapsed() * m_stream->settings().fps / 1000 + 1;
+    while (m_nextFrame < dueFrames) {
+        const bool keyFrame = m_stream->isKeyFrame(m_nextFrame);
+        if ((m_waitingForKeyFrame && !keyFrame) || m_videoSocket->bytesToWrite() > MAX_SOCKET_BACKLOG) {
+            m_waitingForKeyFrame = true;
+            m_lateFrames++;
+        } else {
+            const QByteArray packet = m_stream->packet(m_nextFrame);
+            m_videoSocket->write(packet);
+            m_sentBytes += packet.size();
+            m_sentFrames++;
+            m_waitingForKeyFrame = false;
+        }
+        m_nextFrame++;
+    }
+}
+
+void GeneratorServer::resetSession()
+{
+    m_timer.stop();
+    if (m_videoSocket) {
+        m_videoSocket->deleteLater();
+        m_videoSocket.clear();
+    }
+    for (QPointer<QTcpSocket> *socket : {&m_audioSocket, &m_controlSocket}) {
+        if (*socket) {
+            (*socket)->abort();
+            (*socket)->deleteLater();
+            socket->clear();
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef GENERATORSERVER_H
+#define GENERATORSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+
+class QTcpSocket;
+class SyntheticStream;
+
+/**
+ * @file generatorserver.h
+ * @brief Defines the GeneratorServer class, one virtual device serving a SyntheticStream.
+ */
+
+/**
+ * @class GeneratorServer
+ * @brief Emulates one scrcpy server (video and control sockets, no audio) on a local port.
+ *
+ * A second socket is answered with codec id 0, as the audio socket of a
+ * device that cannot capture audio, so clients connect with audio on or off.
+ *
+ * Frames are sent on a timer at the stream's frame rate. When the client does
+ * not read fast enough to keep the socket backlog under MAX_SOCKET_BACKLOG,
+ * frames are counted as late and skipped up to the next key frame, so the
+ * client never sees a broken reference chain. A disconnected client may
+ * connect again; the stream then restarts with its preamble.
+ */
+class GeneratorServer : public QObject
+{
+    Q_OBJECT
+public:
+    GeneratorServer(const SyntheticStream *stream, const QString &deviceName, QObject *parent = nullptr);
+
+    bool listen(quint16 port);
+
+    quint64 sentFrames() const { return m_sentFrames; }
+    quint64 lateFrames() const { return m_lateFrames; }
+    qint64 sentBytes() const { return m_sentBytes; }
+    QString deviceName() const { return m_deviceName; }
+
+private:
+    void onNewConnection();
+    void sendDueFrames();
+    void resetSession();
+
+    static constexpr qint64 MAX_SOCKET_BACKLOG = 2 * 1024 * 1024;
+
+    const SyntheticStream *m_stream;
+    QString m_deviceName;
+    QTcpServer m_server;
+    QPointer<QTcpSocket> m_videoSocket;
+    QPointer<QTcpSocket> m_audioSocket;
+    QPointer<QTcpSocket> m_controlSocket;
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_nextFrame = 0;
+    bool m_waitingForKeyFrame = false;
+
+    quint64 m_sentFrames = 0;
+    quint64 m_lateFrames = 0;
+    qint64 m_sentBytes = 0;
+};
+
+#endif // GENERATORSERVER_H
@@ -0,0 +1,161 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTimer>
+#include <QDebug>
+#include "generatorserver.h"
+#include "replayserver.h"
+#include "streamcapture.h"
+#include "syntheticstream.h"
+
+// Serves a capture recorded with "scrcpyNG --capture <file>" to "scrcpyNG --connect <port>",
+// so the decoder and render path can be benchmarked without a device. With --generate it
+// instead emulates any number of devices streaming an encoded test pattern.
+
+static int runReplay(QCoreApplication &app, const QString &capturePath, quint16 port, const QString &pace)
+{
+    if (pace != "original" && pace != "max") {
+        qCritical() << "Invalid pace:" << pace;
+        return 1;
+    }
+
+    QFile file(capturePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot open" << file.fileName() << ":" << file.errorString();
+        return 1;
+    }
+
+    QString error;
+    const QList<StreamCapture::Record> records = StreamCapture::readAll(&file, &error);
+    if (!error.isEmpty()) {
+        if (records.isEmpty()) {
+            qCritical().noquote() << file.fileName() << ":" << error;
+            return 1;
+        }
+        qWarning().noquote() << file.fileName() << ":" << error << "- replaying the" << records.size() << "complete records";
+    }
+
+    ReplayServer server(records, pace == "max" ? ReplayServer::Pace::Maximum : ReplayServer::Pace::Original);
+    QObject::connect(&server, &ReplayServer::finished, &app, &QCoreApplication::quit);
+    if (!server.listen(port)) {
+        return 1;
+    }
+    return app.exec();
+}
+
+static int runGenerator(QCoreApplication &app, const SyntheticStream::Settings &settings,
+                        int devices, quint16 firstPort, int durationSeconds)
+{
+    SyntheticStream stream;
+    QString error;
+    if (!stream.encode(settings, &error)) {
+        qCritical().noquote() << "Cannot generate the test stream:" << error;
+        return 1;
+    }
+    qInfo().noquote() << QString("Encoded a %1-frame %2 loop at %3x%4, %5 kbit/s average")
+                             .arg(stream.loopFrames()).arg(settings.codec)
+                             .arg(settings.size.width()).arg(settings.size.height())
+                             .arg(stream.encodedBytes() * 8 * settings.fps / stream.loopFrames() / 1000);
+
+    QList<GeneratorServer*> servers;
+    for (int i = 0; i < devices; ++i) {
+        auto *server = new GeneratorServer(&stream, QString("Synthetic %1").arg(i + 1), &app);
+        if (!server->listen(static_cast<quint16>(firstPort + i))) {
+            return 1;
+        }
+        servers.append(server);
+    }
+    qInfo().noquote() << QString("%1 virtual device(s) on 127.0.0.1:%2-%3; connect with scrcpyNG --connect <port> "
+                                 "(video codec %4, audio off)")
+                             .arg(devices).arg(firstPort).arg(firstPort + devices - 1).arg(settings.codec);
+
+    auto report = [&servers]() {
+        for (const GeneratorServer *server : std::as_const(servers)) {
+            qInfo().noquote() << QString("%1: %2 frames sent, %3 late, %4 MB")
+                                     .arg(server->deviceName())
+                                     .arg(server->sentFrames())
+                                     .arg(server->lateFrames())
+                                     .arg(server->sentBytes() / 1048576.0, 0, 'f', 1);
+        }
+    };
+
+    QTimer reportTimer;
+    QObject::connect(&reportTimer, &QTimer::timeout, &app, report);
+    reportTimer.start(5000);
+
+    if (durationSeconds > 0) {
+        QTimer::singleShot(durationSeconds * 1000, &app, &QCoreApplication::quit);
+    }
+
+    const int result = app.exec();
+    report();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("scrcpy-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a scrcpyNG stream capture, or generates synthetic devices, "
+                                     "over the scrcpy socket protocol.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "The capture file written by scrcpyNG --capture (replay mode).");
+    QCommandLineOption portOption({"p", "port"}, "Local port to listen on; generated devices use consecutive ports (default 27183).",
+                                  "port", "27183");
+    QCommandLineOption paceOption("pace", "Replay: \"original\" (captured timing, default) or \"max\" (as fast as the client reads).",
+                                  "pace", "original");
+    QCommandLineOption generateOption("generate", "Generate a test pattern of the given size (e.g. 1920x1080) instead of replaying.",
+                                      "WxH");
+    QCommandLineOption fpsOption("fps", "Generator frame rate (default 60).", "fps", "60");
+    QCommandLineOption bitrateOption("bitrate", "Generator bit rate in bit/s (default 8000000).", "bps", "8000000");
+    QCommandLineOption codecOption("codec", "Generator codec: h264, h265 or av1 (default h264).", "codec", "h264");
+    QCommandLineOption gopOption("gop", "Generator key frame interval in frames (default: one second).", "frames");
+    QCommandLineOption devicesOption("devices", "Number of virtual devices to generate (default 1).", "count", "1");
+    QCommandLineOption durationOption("duration", "Generator run time in seconds, 0 = until stopped (default 0).", "seconds", "0");
+    parser.addOptions({portOption, paceOption, generateOption, fpsOption, bitrateOption,
+                       codecOption, gopOption, devicesOption, durationOption});
+    parser.process(app);
+
+    bool ok = false;
+    const quint16 port = parser.value(portOption).toUShort(&ok);
+    if (!ok || port == 0) {
+        qCritical() << "Invalid port:" << parser.value(portOption);
+        return 1;
+    }
+
+    if (!parser.isSet(generateOption)) {
+        const QStringList positional = parser.positionalArguments();
+        if (positional.size() != 1) {
+            parser.showHelp(1);
+        }
+        return runReplay(app, positional.first(), port, parser.value(paceOption));
+    }
+
+    SyntheticStream::Settings settings;
+    const QStringList size = parser.value(generateOption).split('x');
+    bool widthOk = false, heightOk = false;
+    if (size.size() == 2) {
+        settings.size = QSize(size.at(0).toInt(&widthOk), size.at(1).toInt(&heightOk));
+    }
+    settings.fps = parser.value(fpsOption).toInt();
+    settings.bitRate = parser.value(bitrateOption).toLongLong();
+    settings.codec = parser.value(codecOption).toLower();
+    settings.gop = parser.isSet(gopOption) ? parser.value(gopOption).toInt() : settings.fps;
+    const int devices = parser.value(devicesOption).toInt();
+    const int duration = parser.value(durationOption).toInt();
+
+    if (!widthOk || !heightOk || settings.size.width() < 16 || settings.size.height() < 16
+        || settings.size.width() > 8192 || settings.size.height() > 8192) {
+        qCritical() << "Invalid size:" << parser.value(generateOption);
+        return 1;
+    }
+    if (settings.fps <= 0 || settings.fps > 1000 || settings.bitRate <= 0 || settings.gop <= 0
+        || devices <= 0 || port + devices - 1 > 65535 || duration < 0) {
+        qCritical() << "Invalid generator parameters";
+        return 1;
+    }
+
+    return runGenerator(app, settings, devices, port, duration);
+}
@@ -0,0 +1,141 @@
+#include "replayserver.h"
+#include <QDebug>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+ReplayServer::ReplayServer(const QList<StreamCapture::Record> &records, Pace pace, QObject *parent)
+    : QObject(parent), m_records(records), m_pace(pace)
+{
+    for (const StreamCapture::Record &record : m_records) {
+        if (record.channel == StreamCapture::AudioChannel) {
+            m_hasAudio = true;
+            break;
+        }
+    }
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayServer::pump);
+    connect(&m_server, &QTcpServer::newConnection, this, &ReplayServer::onNewConnection);
+}
+
+bool ReplayServer::listen(quint16 port)
+{
+    if (!m_server.listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "[ReplayServer] Cannot listen on port" << port << ":" << m_server.errorString();
+        return false;
+    }
+    qInfo() << "[ReplayServer] Serving" << m_records.size() << "records on 127.0.0.1:" << port
+            << (m_hasAudio ? "(video + audio)" : "(video)");
+    return true;
+}
+
+void ReplayServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        socket->setParent(this);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        // Same order as the scrcpy server: video, audio, control
+        if (m_connections == 0) {
+            m_sockets[StreamCapture::VideoChannel] = socket;
+            connect(socket, &QTcpSocket::bytesWritten, this, [this]() {
+                if (m_pace == Pace::Maximum) pump();
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this]() {
+                if (!m_finishing) {
+                    qWarning() << "[ReplayServer] Client disconnected after" << m_next << "records";
+                    m_finishing = true;
+                    m_timer.stop();
+                    emit finished();
+                }
+            });
+            qDebug() << "[ReplayServer] Video socket connected";
+            m_clock.start();
+            pump();
+        } else if (!m_sockets[StreamCapture::AudioChannel]) {
+            // Taken as audio even without audio in the capture: a client with
+            // audio enabled waits for a codec id on it, and one without ignores
+            // what the server writes to its control socket
+            m_sockets[StreamCapture::AudioChannel] = socket;
+            if (m_hasAudio) {
+                qDebug() << "[ReplayServer] Audio socket connected";
+                socket->write(m_audioBacklog);
+                m_audioBacklog.clear();
+            } else {
+                qDebug() << "[ReplayServer] Audio socket connected, answering with audio disabled";
+                socket->write(QByteArray(4, '\0')); // Codec id 0: audio disabled on the device
+            }
+            connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->readAll(); });
+        } else if (!m_controlSocket) {
+            m_controlSocket = socket;
+            qDebug() << "[ReplayServer] Control socket connected";
+            connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->readAll(); });
+        } else {
+            qWarning() << "[ReplayServer] Unexpected extra connection, closing it";
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+        m_connections++;
+    }
+}
+
+void ReplayServer::pump()
+{
+    QTcpSocket *video = m_sockets[StreamCapture::VideoChannel];
+    if (!video || m_finishing) return;
+
+    while (m_next < m_records.size()) {
+        const StreamCapture::Record &record = m_records.at(m_next);
+
+        if (m_pace == Pace::Original) {
+            const qint64 dueMs = record.timestampUs / 1000 - m_clock.elapsed();
+            if (dueMs > 0) {
+                m_timer.start(static_cast<int>(dueMs));
+                return;
+            }
+        } else if (video->bytesToWrite() > MAX_SOCKET_BACKLOG) {
+            return; // Resumed by bytesWritten
+        }
+
+        send(record);
+        m_next++;
+    }
+
+    finish();
+}
+
+void ReplayServer::send(const StreamCapture::Record &record)
+{
+    QTcpSocket *socket = m_sockets[record.channel];
+    if (socket) {
+        socket->write(record.data);
+    } else if (record.channel == StreamCapture::AudioChannel) {
+        m_audioBacklog.append(record.data);
+    }
+    m_bytesSent += record.data.size();
+}
+
+void ReplayServer::finish()
+{
+    m_finishing = true;
+
+    const qint64 elapsedMs = qMax<qint64>(1, m_clock.elapsed());
+    qInfo().noquote() << QString("[ReplayServer] Sent %1 records, %2 bytes in %3 ms (%4 MB/s)")
+                             .arg(m_records.size())
+                             .arg(m_bytesSent)
+                             .arg(elapsedMs)
+                             .arg(m_bytesSent / 1048.576 / elapsedMs, 0, 'f', 2);
+
+    // disconnectFromHost() closes once the pending data is written
+    QTcpSocket *video = m_sockets[StreamCapture::VideoChannel];
+    for (QTcpSocket *socket : {video, m_sockets[StreamCapture::AudioChannel].data(), m_controlSocket.data()}) {
+        if (socket) socket->disconnectFromHost();
+    }
+
+    if (video && video->state() != QAbstractSocket::UnconnectedState) {
+        connect(video, &QTcpSocket::disconnected, this, &ReplayServer::finished);
+    } else {
+        QTimer::singleShot(0, this, &ReplayServer::finished);
+    }
+}
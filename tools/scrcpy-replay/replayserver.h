@@ -0,0 +1,80 @@
+#ifndef REPLAYSERVER_H
+#define REPLAYSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include "streamcapture.h"
+
+class QTcpSocket;
+
+/**
+ * @file replayserver.h
+ * @brief Defines the ReplayServer class, which serves a stream capture over the scrcpy socket protocol.
+ */
+
+/**
+ * @class ReplayServer
+ * @brief Plays a StreamCapture back to a client connected with "scrcpyNG --connect <port>".
+ *
+ * The server accepts sockets in the order the real server does: video, then
+ * audio, then control. The captured bytes already contain the dummy byte,
+ * device meta, codec headers and packet framing, so they are written back
+ * unchanged. Audio captured before the client opened its audio socket is held
+ * and sent on connection; a capture without audio answers the audio socket
+ * with codec id 0 (disabled), like a device that cannot capture audio.
+ *
+ * Control messages are not part of a capture: the client's input cannot be
+ * replayed against a recorded screen, so the control socket is only drained.
+ *
+ * Pace::Original reproduces the capture's arrival times. Pace::Maximum writes
+ * as fast as the client reads (bounded by MAX_SOCKET_BACKLOG), to measure
+ * decoder and render throughput.
+ */
+class ReplayServer : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Pace {
+        Original,
+        Maximum
+    };
+
+    ReplayServer(const QList<StreamCapture::Record> &records, Pace pace, QObject *parent = nullptr);
+
+    bool listen(quint16 port);
+
+signals:
+    /**
+     * @brief Emitted once every record is written and the client sockets are flushed.
+     */
+    void finished();
+
+private:
+    void onNewConnection();
+    void pump();
+    void send(const StreamCapture::Record &record);
+    void finish();
+
+    static constexpr qint64 MAX_SOCKET_BACKLOG = 4 * 1024 * 1024;
+
+    QTcpServer m_server;
+    QList<StreamCapture::Record> m_records;
+    Pace m_pace;
+    bool m_hasAudio = false;
+
+    QPointer<QTcpSocket> m_sockets[2];  // Indexed by StreamCapture::Channel
+    QPointer<QTcpSocket> m_controlSocket;
+    QByteArray m_audioBacklog;           // Audio sent before the audio socket connected
+    int m_connections = 0;
+
+    int m_next = 0;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_bytesSent = 0;
+    bool m_finishing = false;
+};
+
+#endif // REPLAYSERVER_H
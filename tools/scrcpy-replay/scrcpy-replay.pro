@@ -0,0 +1,32 @@
+QT       = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = scrcpy-replay
+
+# The capture file format is shared with the client
+ROOT_PATH = $$PWD/../..
+INCLUDEPATH += $$ROOT_PATH
+
+SOURCES += \
+    $$ROOT_PATH/streamcapture.cpp \
+    generatorserver.cpp \
+    main.cpp \
+    replayserver.cpp \
+    syntheticstream.cpp
+
+HEADERS += \
+    $$ROOT_PATH/streamcapture.h \
+    generatorserver.h \
+    replayserver.h \
+    syntheticstream.h
+
+# ===================================================================
+# FFmpeg Integration (test pattern encoding)
+# ===================================================================
+FFMPEG_PATH = $$ROOT_PATH/3rdparty/ffmpeg
+INCLUDEPATH += $$FFMPEG_PATH/include
+LIBS += -L$$FFMPEG_PATH/lib \
+        -lavcodec \
+        -lavutil
@@ -0,0 +1,191 @@
+#include "syntheticstream.h"
+#include <QtEndian>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+}
+
+// Packet header flags, as in VideoDecoderThread
+static constexpr quint64 PACKET_FLAG_CONFIG = quint64(1) << 63;
+static constexpr quint64 PACKET_FLAG_KEY_FRAME = quint64(1) << 62;
+
+// Draws a diagonal gradient scrolling with time and a bouncing bright box,
+// so every frame differs and motion estimation has something to do.
+static void drawPattern(AVFrame *frame, qint64 index)
+{
+    const int w = frame->width;
+    const int h = frame->height;
+    const int shift = static_cast<int>(index * 4);
+
+    for (int y = 0; y < h; ++y) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < w; ++x) {
+            row[x] = static_cast<uint8_t>((x + y + shift) & 0xff);
+        }
+    }
+
+    const int box = qMax(16, h / 8) & ~1;
+    const int travelX = qMax(1, w - box);
+    const int travelY = qMax(1, h - box);
+    const int boxX = static_cast<int>((index * 7) % (2 * travelX));
+    const int boxY = static_cast<int>((index * 5) % (2 * travelY));
+    const int left = boxX < travelX ? boxX : 2 * travelX - boxX;
+    const int top = boxY < travelY ? boxY : 2 * travelY - boxY;
+    for (int y = top; y < top + box && y < h; ++y) {
+        memset(frame->data[0] + y * frame->linesize[0] + left, 235, static_cast<size_t>(qMin(box, w - left)));
+    }
+
+    for (int plane = 1; plane <= 2; ++plane) {
+        const uint8_t value = static_cast<uint8_t>(128 + ((plane == 1 ? shift : -shift) & 0x3f) - 32);
+        for (int y = 0; y < h / 2; ++y) {
+            memset(frame->data[plane] + y * frame->linesize[plane], value, static_cast<size_t>(w / 2));
+        }
+    }
+}
+
+bool SyntheticStream::encode(const Settings &settings, QString *error)
+{
+    m_settings = settings;
+    m_packets.clear();
+    m_config.clear();
+    m_encodedBytes = 0;
+
+    AVCodecID codecId;
+    if (settings.codec == "h265" || settings.codec == "hevc") {
+        codecId = AV_CODEC_ID_HEVC;
+        m_codecTag = 0x68323635; // "h265"
+    } else if (settings.codec == "av1") {
+        codecId = AV_CODEC_ID_AV1;
+        m_codecTag = 0x00617631; // "av1"
+    } else {
+        codecId = AV_CODEC_ID_H264;
+        m_codecTag = 0x68323634; // "h264"
+    }
+
+    const AVCodec *codec = avcodec_find_encoder(codecId);
+    if (!codec) {
+        *error = QString("No %1 encoder in this FFmpeg build").arg(settings.codec);
+        return false;
+    }
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *packet = av_packet_alloc();
+    bool ok = context && frame && packet;
+
+    if (ok) {
+        context->width = settings.size.width() & ~1;
+        context->height = settings.size.height() & ~1;
+        context->pix_fmt = AV_PIX_FMT_YUV420P;
+        context->time_base = AVRational{1, settings.fps};
+        context->framerate = AVRational{settings.fps, 1};
+        context->bit_rate = settings.bitRate;
+        context->gop_size = settings.gop;
+        context->max_b_frames = 0; // Like the device encoders: one packet per frame, in order
+        // Parameter sets go to extradata, to be sent as scrcpy's config packet
+        context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        av_opt_set(context->priv_data, "preset", "ultrafast", 0);
+        av_opt_set(context->priv_data, "tune", "zerolatency", 0);
+
+        ok = avcodec_open2(context, codec, nullptr) >= 0;
+        if (!ok) {
+            *error = QString("Cannot open the %1 encoder (%2) at %3x%4")
+                         .arg(settings.codec, codec->name).arg(context->width).arg(context->height);
+        }
+    } else {
+        *error = "Out of memory";
+    }
+
+    if (ok) {
+        m_config = QByteArray(reinterpret_cast<const char*>(context->extradata), context->extradata_size);
+
+        frame->format = context->pix_fmt;
+        frame->width = context->width;
+        frame->height = context->height;
+        ok = av_frame_get_buffer(frame, 0) >= 0;
+    }
+
+    const int gops = qMax(1, (settings.loopSeconds * settings.fps + settings.gop - 1) / settings.gop);
+    const int frames = gops * settings.gop;
+
+    auto drain = [&]() {
+        while (avcodec_receive_packet(context, packet) == 0) {
+            EncodedPacket encoded;
+            encoded.data = QByteArray(reinterpret_cast<const char*>(packet->data), packet->size);
+            encoded.keyFrame = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+            m_encodedBytes += packet->size;
+            m_packets.append(encoded);
+            av_packet_unref(packet);
+        }
+    };
+
+    for (int i = 0; ok && i < frames; ++i) {
+        ok = av_frame_make_writable(frame) >= 0;
+        if (!ok) break;
+        drawPattern(frame, i);
+        frame->pts = i;
+        // The loop restarts at frame 0, so every GOP boundary must really be a key frame
+        frame->pict_type = (i % settings.gop == 0) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+        ok = avcodec_send_frame(context, frame) >= 0;
+        drain();
+    }
+    if (ok) {
+        avcodec_send_frame(context, nullptr);
+        drain();
+    }
+
+    if (ok && (m_packets.isEmpty() || !m_packets.first().keyFrame)) {
+        *error = "The encoder did not start with a key frame";
+        ok = false;
+    } else if (!ok && error->isEmpty()) {
+        *error = "Encoding failed";
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+    return ok;
+}
+
+QByteArray SyntheticStream::frameHeader(quint64 ptsAndFlags, quint32 size)
+{
+    QByteArray header(12, Qt::Uninitialized);
+    uchar *raw = reinterpret_cast<uchar*>(header.data());
+    qToBigEndian<quint64>(ptsAndFlags, raw);
+    qToBigEndian<quint32>(size, raw + 8);
+    return header;
+}
+
+QByteArray SyntheticStream::preamble(const QString &deviceName) const
+{
+    QByteArray bytes(1, '\0'); // Dummy byte
+
+    QByteArray name = deviceName.toUtf8().left(63);
+    name.resize(64, '\0');
+    bytes += name;
+
+    QByteArray codecHeader(12, Qt::Uninitialized);
+    uchar *raw = reinterpret_cast<uchar*>(codecHeader.data());
+    qToBigEndian<quint32>(m_codecTag, raw);
+    qToBigEndian<quint32>(static_cast<quint32>(m_settings.size.width() & ~1), raw + 4);
+    qToBigEndian<quint32>(static_cast<quint32>(m_settings.size.height() & ~1), raw + 8);
+    bytes += codecHeader;
+
+    if (!m_config.isEmpty()) {
+        bytes += frameHeader(PACKET_FLAG_CONFIG, static_cast<quint32>(m_config.size()));
+        bytes += m_config;
+    }
+    return bytes;
+}
+
+QByteArray SyntheticStream::packet(qint64 index) const
+{
+    const EncodedPacket &encoded = m_packets.at(static_cast<int>(index % m_packets.size()));
+    quint64 ptsAndFlags = static_cast<quint64>(index * 1000000 / m_settings.fps);
+    if (encoded.keyFrame) {
+        ptsAndFlags |= PACKET_FLAG_KEY_FRAME;
+    }
+    return frameHeader(ptsAndFlags, static_cast<quint32>(encoded.data.size())) + encoded.data;
+}
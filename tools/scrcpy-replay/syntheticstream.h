@@ -0,0 +1,77 @@
+#ifndef SYNTHETICSTREAM_H
+#define SYNTHETICSTREAM_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+/**
+ * @file syntheticstream.h
+ * @brief Defines the SyntheticStream class, an encoded test pattern framed like a scrcpy video stream.
+ */
+
+/**
+ * @class SyntheticStream
+ * @brief Encodes a moving test pattern once and serves it in scrcpy framing as an endless stream.
+ *
+ * A loop of frames (a whole number of GOPs, starting with a key frame) is
+ * encoded with libavcodec up front, so serving many virtual devices costs
+ * almost no CPU on the generating side. packet() repeats the loop with
+ * continuously increasing timestamps; the encoder's parameter sets are sent
+ * first as a config packet, as the scrcpy server does.
+ */
+class SyntheticStream
+{
+public:
+    struct Settings {
+        QSize size = QSize(1280, 720);
+        int fps = 60;
+        qint64 bitRate = 8000000;
+        QString codec = "h264";   // "h264", "h265" or "av1", as in the client's video codec option
+        int gop = 60;             // Frames between key frames
+        int loopSeconds = 4;      // Rounded up to whole GOPs
+    };
+
+    /**
+     * @brief Encodes the loop. Must succeed before any other call.
+     * @param error Set to a description on failure.
+     */
+    bool encode(const Settings &settings, QString *error);
+
+    const Settings &settings() const { return m_settings; }
+    int loopFrames() const { return m_packets.size(); }
+    qint64 encodedBytes() const { return m_encodedBytes; }
+
+    /**
+     * @brief The stream preamble: dummy byte, 64-byte device name, codec header and config packet.
+     */
+    QByteArray preamble(const QString &deviceName) const;
+
+    /**
+     * @brief The framed packet for frame @p index (any index >= 0, the loop repeats).
+     */
+    QByteArray packet(qint64 index) const;
+
+    bool isKeyFrame(qint64 index) const { return m_packets.at(static_cast<int>(index % m_packets.size())).keyFrame; }
+
+    // Unframed data, for feeding a decoder directly (bench/)
+    QByteArray config() const { return m_config; }
+    QByteArray payload(qint64 index) const { return m_packets.at(static_cast<int>(index % m_packets.size())).data; }
+
+private:
+    struct EncodedPacket {
+        QByteArray data;
+        bool keyFrame = false;
+    };
+
+    static QByteArray frameHeader(quint64 ptsAndFlags, quint32 size);
+
+    Settings m_settings;
+    quint32 m_codecTag = 0;
+    QByteArray m_config;
+    QList<EncodedPacket> m_packets;
+    qint64 m_encodedBytes = 0;
+};
+
+#endif // SYNTHETICSTREAM_H
@@ -22,11 +22,14 @@ void UiStateManager::initializeStates()
     updateConnectedDeviceStatus();
 
     // Initialize the headers for the device status table.
-    m_ui->tableWidget_deviceStatus->setColumnCount(5);
-    m_ui->tableWidget_deviceStatus->setHorizontalHeaderLabels({"Serial/ID", "Connection", "Status", "Resolution", "Device Name"});
-    // Make the first and last columns stretch to fill available space.
-    m_ui->tableWidget_deviceStatus->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
-    m_ui->tableWidget_deviceStatus->horizontalHeader()->setSectionResizeMode(4, QHeaderView::Stretch);
+    m_ui->tableWidget_deviceStatus->setColumnCount(COLUMN_COUNT);
+    m_ui->tableWidget_deviceStatus->setHorizontalHeaderLabels({"Serial/ID", "Connection", "Status", "Resolution", "Device Name",
+                                                              "FPS In", "FPS Out", "Dropped", "Bitrate", "Decode",
+                                                              "Queue", "Latency p50/p99", "Audio Buffer"});
+    // Make the serial and name columns stretch to fill available space; the metrics fit their contents.
+    m_ui->tableWidget_deviceStatus->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_ui->tableWidget_deviceStatus->horizontalHeader()->setSectionResizeMode(SerialColumn, QHeaderView::Stretch);
+    m_ui->tableWidget_deviceStatus->horizontalHeader()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
 }
 
 void UiStateManager::setDeviceWindowsMap(const QMap<QString, DeviceWindow*> *deviceWindows)
@@ -78,6 +81,9 @@ void UiStateManager::addDeviceToStatusTable(const QString &serial)
     m_ui->tableWidget_deviceStatus->setItem(rowCount, 2, new QTableWidgetItem("Connecting..."));
     m_ui->tableWidget_deviceStatus->setItem(rowCount, 3, new QTableWidgetItem("N/A"));
     m_ui->tableWidget_deviceStatus->setItem(rowCount, 4, new QTableWidgetItem("N/A"));
+    for (int column = FpsInColumn; column < COLUMN_COUNT; ++column) {
+        m_ui->tableWidget_deviceStatus->setItem(rowCount, column, new QTableWidgetItem("-"));
+    }
 }
 
 void UiStateManager::removeDeviceFromStatusTable(const QString &serial)
@@ -106,6 +112,36 @@ void UiStateManager::updateDeviceStatusInfo(const QString &serial, const QString
     }
 }
 
+void UiStateManager::updateDeviceMetrics(const DeviceMetrics &metrics)
+{
+    const int row = statusRowForSerial(metrics.serial);
+    if (row < 0) return;
+
+    auto setCell = [this, row](int column, const QString &text) {
+        m_ui->tableWidget_deviceStatus->item(row, column)->setText(text);
+    };
+    setCell(FpsInColumn, QString::number(metrics.fpsIn, 'f', 1));
+    setCell(FpsOutColumn, QString::number(metrics.fpsOut, 'f', 1));
+    setCell(DroppedColumn, QString::number(metrics.droppedFrames));
+    setCell(BitrateColumn, QString("%1 Mbps").arg(metrics.bitrateKbps / 1000.0, 0, 'f', 1));
+    setCell(DecodeColumn, QString("%1 ms").arg(metrics.decodeMs, 0, 'f', 1));
+    setCell(QueueColumn, QString::number(metrics.queueDepth));
+    setCell(LatencyColumn, QString("%1 / %2 ms").arg(metrics.latencyP50Ms, 0, 'f', 1).arg(metrics.latencyP99Ms, 0, 'f', 1));
+    setCell(AudioColumn, metrics.audio ? QString("%1 ms, %2 underruns").arg(metrics.audioBufferMs).arg(metrics.audioUnderruns)
+                                       : QString("-"));
+}
+
+int UiStateManager::statusRowForSerial(const QString &serial) const
+{
+    for (int i = 0; i < m_ui->tableWidget_deviceStatus->rowCount(); ++i) {
+        QTableWidgetItem* item = m_ui->tableWidget_deviceStatus->item(i, SerialColumn);
+        if (item && item->text() == serial) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // --- Private Implementation of Specific UI State Logic ---
 
 void UiStateManager::updateVideoControlsState()
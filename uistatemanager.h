@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QMap>
 #include <QSize> // Include QSize for the frame size parameter
+#include "metricsexporter.h"
 
 // Forward declarations to avoid circular header dependencies.
 namespace Ui {
@@ -86,7 +87,36 @@ public slots:
      */
     void updateDeviceStatusInfo(const QString &serial, const QString &deviceName, const QSize &frameSize);
 
+    /**
+     * @brief Updates the live metrics columns (fps, drops, bitrate, decode time, queue, latency, audio) of a device.
+     * @param metrics The latest sample from the device's window.
+     */
+    void updateDeviceMetrics(const DeviceMetrics &metrics);
+
 private:
+    // Columns of the device status table
+    enum Column {
+        SerialColumn,
+        ConnectionColumn,
+        StateColumn,
+        ResolutionColumn,
+        NameColumn,
+        FpsInColumn,
+        FpsOutColumn,
+        DroppedColumn,
+        BitrateColumn,
+        DecodeColumn,
+        QueueColumn,
+        LatencyColumn,
+        AudioColumn,
+        COLUMN_COUNT
+    };
+
+    /**
+     * @brief Returns the status table row of a device, or -1.
+     */
+    int statusRowForSerial(const QString &serial) const;
+
     // --- Private Helper Methods for Specific UI Areas ---
     void updateVideoControlsState();
     void updateAudioControlsState();
@@ -1,22 +1,23 @@
 #include "videodecoderthread.h"
+#include "decoderthreadbudget.h"
+#include "streamcapture.h"
+#include "streamrecorder.h"
+#include "threadpolicy.h"
+#include "yuvconverter.h"
 #include <QDebug>
 #include <QtEndian>
-
-#ifdef Q_OS_WIN
-#include <windows.h>
-#elif defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-#include <pthread.h>
-#include <sched.h>
-#endif
+#include <QTcpSocket>
+#include <QMutexLocker>
+#include <QtMath>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
+#include <libavutil/buffer.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/pixfmt.h>
 #include <libavutil/error.h>
-#include <libavutil/opt.h>
 }
 
 // Inline helpers for speed
@@ -33,10 +34,9 @@ static inline quint64 read_be64(const uchar *data) {
 }
 
 VideoDecoderThread::VideoDecoderThread(const QString &codecName, QObject *parent)
-    : QThread(parent), mRunning(false), mCodecName(codecName)
+    : QThread(parent), mRunning(false), mCodecName(codecName),
+      m_targetSize(0), m_swsFlags(SWS_FAST_BILINEAR)
 {
-    // Pre-allocate buffer to reduce reallocations
-    m_buffer.reserve(INITIAL_BUFFER_CAPACITY);
 }
 
 VideoDecoderThread::~VideoDecoderThread()
@@ -52,6 +52,166 @@ void VideoDecoderThread::stop()
     mRunning = false;
 }
 
+void VideoDecoderThread::attachSocket(QTcpSocket *socket, const QSharedPointer<StreamRecorder> &recorder)
+{
+    if (!socket) return;
+
+    // A QObject can only change threads when it has no parent
+    socket->setParent(nullptr);
+    socket->moveToThread(this);
+
+    // Runs in the decoder thread once its event loop picks it up
+    QMetaObject::invokeMethod(socket, [this, socket, recorder]() {
+        if (m_videoSocket) {
+            resetStream();
+        }
+        m_recorder = recorder;
+        m_videoSocket = socket;
+        connect(socket, &QTcpSocket::readyRead, socket, [this]() { readFromSocket(); });
+        connect(socket, &QTcpSocket::disconnected, socket, [this]() { emit socketDisconnected(); });
+
+        // Drain whatever arrived before the hand-over
+        readFromSocket();
+    }, Qt::QueuedConnection);
+}
+
+void VideoDecoderThread::resetStream()
+{
+    qDebug() << "[Decoder] New stream, resuming at its first key frame";
+    m_videoSocket->disconnect();
+    m_videoSocket->abort();
+    delete m_videoSocket;
+    m_videoSocket = nullptr;
+    resetParser();
+}
+
+void VideoDecoderThread::dropStream()
+{
+    // Otherwise the session would freeze on its last frame while the socket
+    // keeps buffering everything the device sends. The socket's readyRead is
+    // still on the stack, hence deleteLater().
+    qWarning() << "[Decoder] Dropping the stream after a fatal error";
+    m_videoSocket->disconnect();
+    m_videoSocket->abort();
+    m_videoSocket->deleteLater();
+    m_videoSocket = nullptr;
+    resetParser();
+    m_streamFailed = false;
+    emit socketDisconnected();
+}
+
+void VideoDecoderThread::resetParser()
+{
+    // A capture file holds exactly one stream
+    m_capture.reset();
+
+    m_state = STATE_READING_DUMMY_BYTE;
+    m_headerFilled = 0;
+    m_payloadSize = 0;
+    m_payloadFilled = 0;
+    if (m_payloadBuffer) {
+        av_buffer_unref(&m_payloadBuffer);
+    }
+    m_pendingConfig.clear();
+    m_lastPts = -1;
+    m_resyncing = false;
+
+    // The codec is flushed on the new stream's first key frame, which the server
+    // sends right away, so there is no need to ask for one
+    m_awaitingKeyFrame = true;
+    m_lastKeyFrameRequestUs = LatencyTracker::nowUs();
+}
+
+void VideoDecoderThread::setProfile(const DecoderProfile &profile)
+{
+    m_profile = profile;
+    m_mailbox.setDepth(profile.displayQueueDepth);
+    m_framePool.reserve(FRAME_POOL_SIZE + profile.displayQueueDepth - 1);
+}
+
+void VideoDecoderThread::setTargetSize(const QSize &size, qreal devicePixelRatio)
+{
+    m_targetDprPermille.storeRelaxed(qMax(1, qRound(devicePixelRatio * 1000)));
+    const quint64 packed = size.isEmpty()
+        ? 0
+        : (static_cast<quint64>(size.width()) << 32) | static_cast<quint32>(size.height());
+    m_targetSize.storeRelaxed(packed);
+}
+
+void VideoDecoderThread::setScaleQuality(const QString &quality)
+{
+    int flags = SWS_FAST_BILINEAR;
+    if (quality == "bilinear") {
+        flags = SWS_BILINEAR;
+    } else if (quality == "bicubic") {
+        flags = SWS_BICUBIC;
+    }
+    m_swsFlags.storeRelaxed(flags);
+}
+
+void VideoDecoderThread::setPresentationEnabled(bool enabled, bool skipNonReference)
+{
+    m_skipNonReference.storeRelaxed(skipNonReference ? 1 : 0);
+    if (m_presenting.fetchAndStoreRelaxed(enabled ? 1 : 0) != (enabled ? 1 : 0)) {
+        m_presentationChanges.fetchAndAddRelaxed(1);
+    }
+    if (!enabled) {
+        // Give the pending frame's buffer back to the pool
+        m_mailbox.clear();
+    }
+}
+
+QImage VideoDecoderThread::grabFullResolutionFrame()
+{
+    return grabLatestFrame(true);
+}
+
+QImage VideoDecoderThread::grabViewportFrame()
+{
+    return grabLatestFrame(false);
+}
+
+QImage VideoDecoderThread::grabLatestFrame(bool fullResolution)
+{
+    AVFrame *frame = nullptr;
+    {
+        QMutexLocker locker(&m_lastFrameMutex);
+        if (m_lastFrame && m_lastFrame->buf[0]) {
+            frame = av_frame_clone(m_lastFrame); // New reference, no pixel copy
+        }
+    }
+    if (!frame) {
+        return QImage();
+    }
+
+    // One-off conversion on the caller's thread, the decoder's context is not touched
+    QImage image;
+    const QSize source(frame->width, frame->height);
+    const QSize size = fullResolution ? source : outputSizeFor(frame->width, frame->height);
+    const int swsFlags = fullResolution ? SWS_BICUBIC : m_swsFlags.loadRelaxed();
+    if ((size == source || swsFlags != SWS_BICUBIC) && YuvConverter::canConvert(frame, size)) {
+        image = QImage(size, QImage::Format_RGB32);
+        YuvConverter::convert(frame, image);
+        av_frame_free(&frame);
+        return image;
+    }
+
+    SwsContext *context = sws_getContext(
+        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+        size.width(), size.height(), AV_PIX_FMT_RGB32,
+        swsFlags, nullptr, nullptr, nullptr);
+    if (context) {
+        image = QImage(size, QImage::Format_RGB32);
+        const int stride[] = { static_cast<int>(image.bytesPerLine()) };
+        uint8_t* dest[] = { image.bits() };
+        sws_scale(context, frame->data, frame->linesize, 0, frame->height, dest, stride);
+        sws_freeContext(context);
+    }
+
+    av_frame_free(&frame);
+    return image;
+}
+
 bool VideoDecoderThread::initializeDecoder()
 {
     AVCodecID codecId;
@@ -70,43 +230,95 @@ bool VideoDecoderThread::initializeDecoder()
         emit errorOccurred(QString("Decoder not found: %1").arg(mCodecName));
         return false;
     }
+    m_codec = codec;
+
+    // Threads come from the process-wide budget; the size is only known from the video header
+    m_budgetVisible = m_presenting.loadRelaxed();
+    m_budgetSession = DecoderThreadBudget::instance().registerSession(QSize(), m_budgetVisible,
+                                                                      m_profile.frameThreading);
+    if (!openCodec(codec)) {
+        return false;
+    }
 
+    m_packet = av_packet_alloc();
+    m_frame = av_frame_alloc();
+    {
+        QMutexLocker locker(&m_lastFrameMutex);
+        m_lastFrame = av_frame_alloc();
+    }
+
+    if (!m_packet || !m_frame || !m_lastFrame) {
+        emit errorOccurred("Failed to allocate packet/frame");
+        return false;
+    }
+
+    return true;
+}
+
+bool VideoDecoderThread::openCodec(const AVCodec *codec)
+{
+    DecoderThreadBudget &budget = DecoderThreadBudget::instance();
+    // Read before the allocation, so a change in between is picked up next time
+    m_budgetGeneration = budget.generation();
+    const DecoderThreadBudget::Allocation allocation = budget.allocationFor(m_budgetSession);
+
+    if (m_codecContext) {
+        avcodec_free_context(&m_codecContext);
+    }
     m_codecContext = avcodec_alloc_context3(codec);
     if (!m_codecContext) {
         emit errorOccurred("Failed to allocate codec context");
         return false;
     }
 
-    // Performance optimizations
-    m_codecContext->thread_count = 0; // Auto-detect (faster than manual)
-    m_codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    m_codecContext->thread_count = allocation.threadCount;
+    m_codecContext->thread_type = allocation.threadType;
 
     m_codecContext->max_b_frames = 0;  // No B-frames buffering
     m_codecContext->has_b_frames = 0;
 
-    // Low-latency decoding for real-time streaming
-    m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
-    m_codecContext->flags2 |= AV_CODEC_FLAG2_FAST;
-
-    av_opt_set_int(m_codecContext->priv_data, "delay", 0, 0);
-    if (codecId == AV_CODEC_ID_H264) {
-        av_opt_set(m_codecContext->priv_data, "tune", "zerolatency", 0);
-        av_opt_set_int(m_codecContext->priv_data, "slice-max-size", 1500, 0); // MTU-sized slices
+    // Output frames as soon as they are decoded. The flag rules out frame
+    // threading, so it is left off when the budget asks for frame threads.
+    if (m_profile.lowDelay && allocation.threadType != FF_THREAD_FRAME) {
+        m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+    if (m_profile.fast) {
+        m_codecContext->flags2 |= AV_CODEC_FLAG2_FAST;
     }
+    m_codecContext->skip_loop_filter = static_cast<AVDiscard>(m_profile.skipLoopFilter);
+    // Packet timestamps from the device are in microseconds
+    m_codecContext->pkt_timebase = AVRational{1, 1000000};
+    // Carries the latency trace sequence number from packet to frame
+    m_codecContext->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+
     if (avcodec_open2(m_codecContext, codec, nullptr) < 0) {
         emit errorOccurred("Failed to open codec");
         avcodec_free_context(&m_codecContext);
         return false;
     }
 
-    m_packet = av_packet_alloc();
-    m_frame = av_frame_alloc();
+    m_threadAllocation = allocation;
+    qDebug() << "[Decoder] Decoding" << m_profile.name << "with" << allocation.threadCount
+             << (allocation.threadType == FF_THREAD_FRAME ? "frame" : "slice") << "thread(s)";
+    return true;
+}
 
-    if (!m_packet || !m_frame) {
-        emit errorOccurred("Failed to allocate packet/frame");
+bool VideoDecoderThread::rebalanceThreads()
+{
+    DecoderThreadBudget &budget = DecoderThreadBudget::instance();
+    if (m_budgetSession < 0 || !m_codecContext || budget.generation() == m_budgetGeneration) {
+        return false;
+    }
+    if (budget.allocationFor(m_budgetSession) == m_threadAllocation) {
+        m_budgetGeneration = budget.generation();
         return false;
     }
 
+    // Frames still held back by frame threads are dropped; the next packet is a key frame
+    if (!openCodec(m_codec)) {
+        m_streamFailed = true;
+        return false;
+    }
     return true;
 }
 
@@ -114,18 +326,10 @@ void VideoDecoderThread::run()
 {
     mRunning = true;
 
-    #ifdef Q_OS_WIN
-        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
-    #else
-        // Linux/macOS: Use nice value
-        struct sched_param param;
-        param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
-        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
-    #endif
-
-    qDebug() << "[Decoder] Thread priority elevated for low latency";
+    ThreadPolicy::instance().applyToCurrentThread(ThreadPolicy::VideoDecode);
 
     if (!initializeDecoder()) {
+        ThreadPolicy::instance().releaseCurrentThread();
         emit decodingFinished("Decoder initialization failed");
         return;
     }
@@ -133,12 +337,24 @@ void VideoDecoderThread::run()
     emit decodingFinished("Decoder ready");
     exec();
 
+    // The socket lives in this thread, so it must also be destroyed here
+    if (m_videoSocket) {
+        m_videoSocket->abort();
+        delete m_videoSocket;
+        m_videoSocket = nullptr;
+    }
+
     cleanup();
+    ThreadPolicy::instance().releaseCurrentThread();
     emit decodingFinished("Decoder stopped");
 }
 
 void VideoDecoderThread::cleanup()
 {
+    if (m_budgetSession >= 0) {
+        DecoderThreadBudget::instance().unregisterSession(m_budgetSession);
+        m_budgetSession = -1;
+    }
     if (m_swsContext) {
         sws_freeContext(m_swsContext);
         m_swsContext = nullptr;
@@ -146,26 +362,73 @@ void VideoDecoderThread::cleanup()
     if (m_frame) {
         av_frame_free(&m_frame);
     }
+    {
+        QMutexLocker locker(&m_lastFrameMutex);
+        av_frame_free(&m_lastFrame);
+    }
     if (m_packet) {
         av_packet_free(&m_packet);
     }
     if (m_codecContext) {
         avcodec_free_context(&m_codecContext);
     }
+    if (m_payloadBuffer) {
+        av_buffer_unref(&m_payloadBuffer);
+    }
+    // Buffers still referenced by libavcodec keep the pool alive until released
+    av_buffer_pool_uninit(&m_packetPool);
+    m_packetPoolSize = 0;
 }
 
 void VideoDecoderThread::decodeData(const QByteArray &data)
 {
     if (!mRunning || data.isEmpty()) return;
 
-    // CRITICAL: Minimize lock duration
-    {
-        QMutexLocker locker(&m_bufferMutex);
-        m_buffer.append(data);
+    // decodeData() and the parser always run on the same thread, so the chunk
+    // is parsed in place without staging it in an intermediate buffer.
+    processBuffer(reinterpret_cast<const uchar*>(data.constData()), data.size());
+}
+
+QSize VideoDecoderThread::outputSizeFor(int width, int height) const
+{
+    const QSize source(width, height);
+    const quint64 packed = m_targetSize.loadRelaxed();
+    if (packed == 0) {
+        return source;
     }
 
-    // Process outside the lock
-    processBuffer();
+    const QSize target(static_cast<int>(packed >> 32), static_cast<int>(packed & 0xFFFFFFFF));
+    QSize output = source.scaled(target, Qt::KeepAspectRatio);
+
+    // Never scale up: the GUI can stretch a full-resolution frame just as well
+    if (output.width() >= width || output.height() >= height) {
+        return source;
+    }
+    return output.expandedTo(QSize(1, 1));
+}
+
+QRegion VideoDecoderThread::dirtyRegionFor(const QRegion &changed, const QSize &sourceSize, const QSize &outputSize) const
+{
+    // The whole frame is cheaper to repaint as such
+    if (changed.rectCount() == 1 && changed.boundingRect() == QRect(QPoint(0, 0), sourceSize)) {
+        return QRegion();
+    }
+
+    const qreal scaleX = qreal(outputSize.width()) / sourceSize.width();
+    const qreal scaleY = qreal(outputSize.height()) / sourceSize.height();
+    const QRect image(QPoint(0, 0), outputSize);
+
+    // Chroma upsampling reaches a couple of pixels beyond a change, and a
+    // downscaling filter a couple of output pixels, i.e. more source pixels
+    const int margin = 2 + qCeil(2.0 / qMin(scaleX, scaleY));
+
+    QRegion dirty;
+    for (const QRect &rect : changed) {
+        const QRect grown = rect.adjusted(-margin, -margin, margin, margin);
+        dirty += QRectF(grown.x() * scaleX, grown.y() * scaleY,
+                        grown.width() * scaleX, grown.height() * scaleY).toAlignedRect() & image;
+    }
+    return dirty;
 }
 
 QImage VideoDecoderThread::convertFrameToImage(AVFrame* frame)
@@ -174,27 +437,67 @@ QImage VideoDecoderThread::convertFrameToImage(AVFrame* frame)
         return QImage();
     }
 
-    // Recreate SwsContext only when resolution changes
-    if (!m_swsContext || m_lastFrameWidth != frame->width || m_lastFrameHeight != frame->height) {
+    const QSize outputSize = outputSizeFor(frame->width, frame->height);
+    const int swsFlags = m_swsFlags.loadRelaxed();
+
+    // The common decoder formats at full or exactly half size go through the SIMD
+    // kernels; the 2:1 box filter stands in for the fast and bilinear filters only
+    const bool fullSize = outputSize == QSize(frame->width, frame->height);
+    if ((fullSize || swsFlags != SWS_BICUBIC) && YuvConverter::canConvert(frame, outputSize)) {
+        if (m_lastKernelFormat != frame->format || m_lastKernelOutputSize != outputSize) {
+            m_lastKernelFormat = frame->format;
+            m_lastKernelOutputSize = outputSize;
+            qDebug() << "[Decoder] Converting" << QSize(frame->width, frame->height)
+                     << "to" << outputSize << "with" << YuvConverter::kernelName() << "kernels";
+        }
+
+        QImage image = m_framePool.acquire(outputSize);
+        if (!image.isNull()) {
+            // The pool holds no reference, so this does not detach
+            image.setDevicePixelRatio(m_targetDprPermille.loadRelaxed() / 1000.0);
+            YuvConverter::convert(frame, image);
+        }
+        return image;
+    }
+    m_lastKernelFormat = -1;
+
+    // Recreate SwsContext only when the source, the target size or the filter changes
+    if (!m_swsContext
+        || m_lastFrameWidth != frame->width || m_lastFrameHeight != frame->height
+        || m_lastFrameFormat != frame->format
+        || m_lastOutputSize != outputSize || m_lastSwsFlags != swsFlags) {
         if (m_swsContext) {
             sws_freeContext(m_swsContext);
         }
 
         m_swsContext = sws_getContext(
             frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
-            frame->width, frame->height, AV_PIX_FMT_RGB32,
-            SWS_FAST_BILINEAR, // Faster than SWS_BILINEAR
+            outputSize.width(), outputSize.height(), AV_PIX_FMT_RGB32,
+            swsFlags,
             nullptr, nullptr, nullptr);
 
         m_lastFrameWidth = frame->width;
         m_lastFrameHeight = frame->height;
+        m_lastFrameFormat = frame->format;
+        m_lastOutputSize = outputSize;
+        m_lastSwsFlags = swsFlags;
 
         if (!m_swsContext) {
             return QImage();
         }
+
+        qDebug() << "[Decoder] Converting" << QSize(frame->width, frame->height)
+                 << "to" << outputSize;
+    }
+
+    // A null image means the GUI still holds every pooled buffer: skip the
+    // conversion, the frame would only add to the display backlog
+    QImage image = m_framePool.acquire(outputSize);
+    if (image.isNull()) {
+        return QImage();
     }
+    image.setDevicePixelRatio(m_targetDprPermille.loadRelaxed() / 1000.0);
 
-    QImage image(frame->width, frame->height, QImage::Format_RGB32);
     const int stride[] = { static_cast<int>(image.bytesPerLine()) };
     uint8_t* dest[] = { image.bits() };
 
@@ -203,136 +506,451 @@ QImage VideoDecoderThread::convertFrameToImage(AVFrame* frame)
     return image;
 }
 
-void VideoDecoderThread::processBuffer()
+void VideoDecoderThread::readFromSocket()
 {
-    if (!mRunning) return;
+    if (!m_videoSocket) return;
 
-    bool progress = true;
-    while (progress && mRunning) {
-        progress = false;
+    // Read straight into the parser's destination: header bytes land in the
+    // staging buffer and payload bytes in the packet slab.
+    while (mRunning && !m_streamFailed && m_videoSocket->bytesAvailable() > 0) {
+        qint64 capacity = 0;
+        uchar *region = acquireWriteRegion(&capacity);
 
-        // Lock only when reading/modifying buffer
-        m_bufferMutex.lock();
-        int bufferSize = m_buffer.size();
+        const qint64 bytesRead = m_videoSocket->read(reinterpret_cast<char*>(region), capacity);
+        if (bytesRead <= 0) break;
 
-        switch (m_state) {
-        case STATE_READING_DUMMY_BYTE: {
-            if (bufferSize >= 1) {
-                m_buffer.remove(0, 1);
-                m_state = STATE_READING_DEVICE_META;
-                progress = true;
-            }
-            m_bufferMutex.unlock();
-            break;
+        m_lastReadUs = LatencyTracker::nowUs();
+        if (m_capture) {
+            m_capture->write(StreamCapture::VideoChannel, reinterpret_cast<const char*>(region), bytesRead);
         }
+        commitWrite(bytesRead);
+    }
 
-        case STATE_READING_DEVICE_META: {
-            if (bufferSize >= 64) {
-                QByteArray metaData = m_buffer.left(64);
-                m_buffer.remove(0, 64);
-                m_state = STATE_READING_VIDEO_HEADER;
-                progress = true;
-                m_bufferMutex.unlock();
-
-                // Process meta outside lock
-                int nullPos = metaData.indexOf('\0');
-                if (nullPos >= 0) metaData.truncate(nullPos);
-                emit deviceNameReady(QString::fromUtf8(metaData).trimmed());
-            } else {
-                m_bufferMutex.unlock();
-            }
-            break;
+    if (m_streamFailed) {
+        dropStream();
+    }
+}
+
+int VideoDecoderThread::headerSizeForState(int state) const
+{
+    switch (state) {
+    case STATE_READING_DUMMY_BYTE:    return 1;
+    case STATE_READING_DEVICE_META:   return 64;
+    case STATE_READING_VIDEO_HEADER:  return 12;
+    case STATE_READING_PACKET_HEADER: return 12;
+    default:                          return 0;
+    }
+}
+
+uchar *VideoDecoderThread::acquireWriteRegion(qint64 *capacity)
+{
+    if (m_state == STATE_READING_PACKET_PAYLOAD) {
+        *capacity = m_payloadSize - m_payloadFilled;
+        return m_payloadBuffer->data + m_payloadFilled;
+    }
+
+    // Only accept as many bytes as the current header needs, so payload bytes
+    // that follow are never staged here and copied a second time.
+    *capacity = headerSizeForState(m_state) - m_headerFilled;
+    return m_headerBuffer + m_headerFilled;
+}
+
+void VideoDecoderThread::commitWrite(qint64 bytes)
+{
+    m_receivedBytes.fetchAndAddRelaxed(static_cast<quint64>(bytes));
+
+    if (m_state == STATE_READING_PACKET_PAYLOAD) {
+        m_payloadFilled += static_cast<quint32>(bytes);
+        if (m_payloadFilled == m_payloadSize) {
+            decodePayload();
+            m_state = STATE_READING_PACKET_HEADER;
+            m_payloadSize = 0;
+            m_payloadFilled = 0;
         }
+        return;
+    }
 
-        case STATE_READING_VIDEO_HEADER: {
-            if (bufferSize >= 12) {
-                const uchar* header = reinterpret_cast<const uchar*>(m_buffer.constData());
-                quint32 width = read_be32(header + 4);
-                quint32 height = read_be32(header + 8);
-                m_buffer.remove(0, 12);
-                m_state = STATE_READING_PACKET_HEADER;
-                progress = true;
-                m_bufferMutex.unlock();
-
-                if (!validateResolution(width, height)) {
-                    emit errorOccurred(QString("Invalid resolution: %1x%2").arg(width).arg(height));
-                    stop();
-                    return;
-                }
-            } else {
-                m_bufferMutex.unlock();
-            }
-            break;
+    m_headerFilled += static_cast<int>(bytes);
+    if (m_headerFilled == headerSizeForState(m_state)) {
+        m_headerFilled = 0;
+        if (!handleHeader()) {
+            m_streamFailed = true;
         }
+    }
+}
 
-        case STATE_READING_PACKET_HEADER: {
-            if (bufferSize >= 12) {
-                const uchar* header = reinterpret_cast<const uchar*>(m_buffer.constData());
-                m_payloadSize = read_be32(header + 8);
-                m_buffer.remove(0, 12);
+bool VideoDecoderThread::handleHeader()
+{
+    switch (m_state) {
+    case STATE_READING_DUMMY_BYTE:
+        m_state = STATE_READING_DEVICE_META;
+        return true;
+
+    case STATE_READING_DEVICE_META: {
+        const char *name = reinterpret_cast<const char*>(m_headerBuffer);
+        m_state = STATE_READING_VIDEO_HEADER;
+        emit deviceNameReady(QString::fromUtf8(name, qstrnlen(name, 64)).trimmed());
+        return true;
+    }
 
-                if (m_payloadSize == 0) {
-                    progress = true;
-                    m_bufferMutex.unlock();
-                    continue;
-                }
+    case STATE_READING_VIDEO_HEADER: {
+        quint32 width = read_be32(m_headerBuffer + 4);
+        quint32 height = read_be32(m_headerBuffer + 8);
+        if (!validateResolution(width, height)) {
+            emit errorOccurred(QString("Invalid resolution: %1x%2").arg(width).arg(height));
+            return false;
+        }
+        const QSize resolution(static_cast<int>(width), static_cast<int>(height));
+        // The codec is gone if reopening it failed during the previous stream
+        if (!m_codecContext && m_codec && !openCodec(m_codec)) {
+            return false;
+        }
+        if (m_recorder) {
+            m_recorder->setStreamCodec(StreamRecorder::VideoStream, m_codecContext->codec_id, resolution);
+        }
+        if (m_budgetSession >= 0) {
+            // Nothing has been decoded yet, so the codec can be reopened right away
+            DecoderThreadBudget::instance().setResolution(m_budgetSession, resolution);
+            rebalanceThreads();
+        }
+        m_state = STATE_READING_PACKET_HEADER;
+        return true;
+    }
+
+    case STATE_READING_PACKET_HEADER: {
+        const quint64 ptsAndFlags = read_be64(m_headerBuffer);
+        const quint32 size = read_be32(m_headerBuffer + 8);
+        if (!isPlausiblePacketHeader(ptsAndFlags, size)) {
+            return resyncPacketHeader();
+        }
+        if (m_resyncing) {
+            m_resyncing = false;
+            qWarning() << "[Decoder] Stream resynchronised after skipping" << m_resyncBytes << "bytes";
+            startRecovery("Stream resynchronised");
+        }
+
+        m_packetIsConfig = (ptsAndFlags & PACKET_FLAG_CONFIG) != 0;
+        m_packetIsKeyFrame = (ptsAndFlags & PACKET_FLAG_KEY_FRAME) != 0;
+        m_packetPts = m_packetIsConfig ? -1 : static_cast<qint64>(ptsAndFlags & PACKET_PTS_MASK);
+        m_packetReceivedUs = m_lastReadUs;
+        if (!m_packetIsConfig) {
+            m_lastPts = m_packetPts;
+        }
+
+        if (size == 0) {
+            return true;
+        }
+
+        // Like the reference client, a config packet (SPS/PPS) is not decoded on
+        // its own but prepended to the next media packet. The config is copied
+        // into the slab first, so the media payload is still written only once.
+        const quint32 prefix = m_packetIsConfig ? 0 : static_cast<quint32>(m_pendingConfig.size());
+        m_packetHasConfig = prefix > 0;
+        if (!allocatePayloadBuffer(prefix + size)) {
+            emit errorOccurred("Failed to allocate packet buffer");
+            return false;
+        }
+        if (prefix > 0) {
+            memcpy(m_payloadBuffer->data, m_pendingConfig.constData(), prefix);
+            m_pendingConfig.clear();
+        }
+        m_payloadSize = prefix + size;
+        m_payloadFilled = prefix;
+        m_state = STATE_READING_PACKET_PAYLOAD;
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool VideoDecoderThread::isPlausiblePacketHeader(quint64 ptsAndFlags, quint32 size) const
+{
+    if (!m_resyncing) {
+        return size == 0 || validatePacketSize(size);
+    }
+
+    // Sliding over garbage, a header must also look like the stream's own:
+    // a config packet has no timestamp, a media packet one close to the last
+    if (!validatePacketSize(size)) {
+        return false;
+    }
+    const qint64 pts = static_cast<qint64>(ptsAndFlags & PACKET_PTS_MASK);
+    if (ptsAndFlags & PACKET_FLAG_CONFIG) {
+        return pts == 0 && !(ptsAndFlags & PACKET_FLAG_KEY_FRAME);
+    }
+    return m_lastPts < 0 || qAbs(pts - m_lastPts) <= RESYNC_PTS_WINDOW_US;
+}
+
+bool VideoDecoderThread::resyncPacketHeader()
+{
+    if (!m_resyncing) {
+        m_resyncing = true;
+        m_resyncBytes = 0;
+        qWarning() << "[Decoder] Invalid packet header, resynchronising the stream";
+    }
+    if (++m_resyncBytes > MAX_RESYNC_BYTES) {
+        emit errorOccurred(QString("Invalid packet header, no valid packet within %1 bytes").arg(MAX_RESYNC_BYTES));
+        return false;
+    }
+
+    // Slide the header window by one byte and read the next one
+    const int headerSize = headerSizeForState(m_state);
+    memmove(m_headerBuffer, m_headerBuffer + 1, headerSize - 1);
+    m_headerFilled = headerSize - 1;
+    return true;
+}
+
+void VideoDecoderThread::startRecovery(const QString &reason)
+{
+    m_decodeErrors.fetchAndAddRelaxed(1);
+    if (!m_awaitingKeyFrame) {
+        m_awaitingKeyFrame = true;
+        qWarning() << "[Decoder]" << reason << "- dropping packets until the next key frame";
+    }
+    requestKeyFrame();
+}
+
+void VideoDecoderThread::requestKeyFrame()
+{
+    const qint64 now = LatencyTracker::nowUs();
+    if (m_lastKeyFrameRequestUs != 0 && now - m_lastKeyFrameRequestUs < KEYFRAME_REQUEST_INTERVAL_US) {
+        return;
+    }
+    m_lastKeyFrameRequestUs = now;
+    emit keyFrameRequested();
+}
+
+bool VideoDecoderThread::allocatePayloadBuffer(quint32 size)
+{
+    // Grow the slab size geometrically; buffers from the previous pool are
+    // released back to it (and freed) once libavcodec drops its references.
+    if (!m_packetPool || size > m_packetPoolSize) {
+        quint32 poolSize = qMax(INITIAL_PACKET_POOL_SIZE, m_packetPoolSize);
+        while (poolSize < size) {
+            poolSize *= 2;
+        }
+        av_buffer_pool_uninit(&m_packetPool);
+        m_packetPool = av_buffer_pool_init(poolSize + AV_INPUT_BUFFER_PADDING_SIZE, nullptr);
+        m_packetPoolSize = m_packetPool ? poolSize : 0;
+        if (!m_packetPool) {
+            return false;
+        }
+    }
+
+    m_payloadBuffer = av_buffer_pool_get(m_packetPool);
+    if (!m_payloadBuffer) {
+        return false;
+    }
+
+    // libavcodec requires zeroed padding after the payload
+    memset(m_payloadBuffer->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return true;
+}
 
-                if (!validatePacketSize(m_payloadSize)) {
-                    m_bufferMutex.unlock();
-                    emit errorOccurred(QString("Invalid packet size: %1").arg(m_payloadSize));
-                    stop();
-                    return;
+void VideoDecoderThread::prependStreamConfig()
+{
+    if (m_streamConfig.isEmpty()) {
+        return;
+    }
+
+    const int configSize = static_cast<int>(m_streamConfig.size());
+    AVBufferRef *merged = av_buffer_alloc(configSize + m_payloadSize + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!merged) {
+        return;
+    }
+    memcpy(merged->data, m_streamConfig.constData(), configSize);
+    memcpy(merged->data + configSize, m_payloadBuffer->data, m_payloadSize);
+    memset(merged->data + configSize + m_payloadSize, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    av_buffer_unref(&m_payloadBuffer);
+    m_payloadBuffer = merged;
+    m_payloadSize += configSize;
+}
+
+void VideoDecoderThread::decodePayload()
+{
+    if (m_packetIsConfig) {
+        // Held until the next media packet; a newer config replaces an unused one
+        m_pendingConfig = QByteArray(reinterpret_cast<const char*>(m_payloadBuffer->data),
+                                     static_cast<int>(m_payloadSize));
+        m_streamConfig = m_pendingConfig;
+        if (m_recorder) {
+            m_recorder->setExtradata(StreamRecorder::VideoStream, m_pendingConfig);
+        }
+        av_buffer_unref(&m_payloadBuffer);
+        return;
+    }
+
+    // Parse-only use (the demux benchmark) has no decoder
+    if (!m_codecContext) {
+        av_buffer_unref(&m_payloadBuffer);
+        return;
+    }
+
+    // A new thread allocation is applied on a key frame, where a reopened codec can
+    // start over, and decoding resumes there after an error. In both cases the
+    // stream's config goes in front, unless the packet carries it already.
+    const bool resuming = m_awaitingKeyFrame && m_packetIsKeyFrame;
+    const bool reopened = m_packetIsKeyFrame && rebalanceThreads();
+    if ((resuming || reopened) && !m_packetHasConfig) {
+        prependStreamConfig();
+    }
+    if (!m_codecContext) {
+        av_buffer_unref(&m_payloadBuffer);
+        return;
+    }
+
+    // Hand the slab to the packet by reference: avcodec_send_packet() takes its
+    // own reference instead of copying the payload.
+    m_packet->buf = m_payloadBuffer;
+    m_packet->data = m_payloadBuffer->data;
+    m_packet->size = static_cast<int>(m_payloadSize);
+    m_payloadBuffer = nullptr;
+
+    // Device timestamps are in microseconds (see pkt_timebase)
+    m_packet->pts = m_packetPts;
+    m_packet->dts = m_packetPts;
+    if (m_packetIsKeyFrame) {
+        m_packet->flags |= AV_PKT_FLAG_KEY;
+    }
+    if (m_recorder) {
+        m_recorder->pushPacket(StreamRecorder::VideoStream, m_packet);
+    }
+
+    PacketTiming &timing = m_timingRing[m_timingSequence % TIMING_RING_SIZE];
+    timing.receivedUs = m_packetReceivedUs;
+    timing.parsedUs = LatencyTracker::nowUs();
+    m_packet->opaque = reinterpret_cast<void*>(static_cast<intptr_t>(m_timingSequence));
+    m_timingSequence++;
+
+    // Recording keeps every packet; only the decoder skips what it cannot use
+    if (m_awaitingKeyFrame) {
+        if (!resuming) {
+            requestKeyFrame();
+            av_packet_unref(m_packet);
+            return;
+        }
+        avcodec_flush_buffers(m_codecContext);
+        m_awaitingKeyFrame = false;
+        m_lastKeyFrameRequestUs = 0;
+        qDebug() << "[Decoder] Resuming at a key frame";
+    }
+
+    // Hidden: decode to keep the references, but nothing is converted or shown
+    const bool presenting = m_presenting.loadRelaxed();
+    if (presenting != m_budgetVisible && m_budgetSession >= 0) {
+        m_budgetVisible = presenting;
+        DecoderThreadBudget::instance().setVisible(m_budgetSession, presenting);
+    }
+    const AVDiscard skipFrame = (!presenting && m_skipNonReference.loadRelaxed()) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    if (m_codecContext->skip_frame != skipFrame) {
+        m_codecContext->skip_frame = skipFrame;
+        qDebug() << "[Decoder]" << (presenting ? "Presenting frames again" : "Decode-only, non-reference frames skipped");
+    }
+
+    const int sent = avcodec_send_packet(m_codecContext, m_packet);
+    if (sent < 0 && sent != AVERROR(EAGAIN)) {
+        char error[AV_ERROR_MAX_STRING_SIZE] = {};
+        av_strerror(sent, error, sizeof(error));
+        startRecovery(QString("Decoding failed: %1").arg(error));
+    } else if (sent >= 0) {
+        // ✅ CRITICAL: Process ALL available frames immediately
+        int frameCount = 0;
+        int received = 0;
+        while ((received = avcodec_receive_frame(m_codecContext, m_frame)) == 0) {
+            // Concealed errors or missing references: not worth showing, and
+            // everything after it would inherit the damage
+            if (m_awaitingKeyFrame
+                || m_frame->decode_error_flags != 0 || (m_frame->flags & AV_FRAME_FLAG_CORRUPT)) {
+                if (!m_awaitingKeyFrame) {
+                    startRecovery("Corrupt frame");
                 }
+                continue;
+            }
+            {
+                QMutexLocker locker(&m_lastFrameMutex);
+                av_frame_unref(m_lastFrame);
+                av_frame_ref(m_lastFrame, m_frame);
+            }
+            m_decodedFrames.fetchAndAddRelaxed(1);
 
-                m_state = STATE_READING_PACKET_PAYLOAD;
-                progress = true;
+            if (!presenting) {
+                continue;
+            }
+
+            // After a hide and show the GUI shows a grabbed frame, not the last one posted
+            const int presentationChanges = m_presentationChanges.loadRelaxed();
+            if (presentationChanges != m_seenPresentationChanges) {
+                m_seenPresentationChanges = presentationChanges;
+                m_changeDetector.reset();
+            }
+
+            // A frame identical to the one on screen (a static screen, the encoder
+            // repeating itself) is neither converted nor presented
+            const QSize sourceSize(m_frame->width, m_frame->height);
+            const QSize outputSize = outputSizeFor(m_frame->width, m_frame->height);
+            const int swsFlags = m_swsFlags.loadRelaxed();
+            const bool sameConversion = outputSize == m_postedOutputSize && swsFlags == m_postedSwsFlags;
+            const QRegion changed = sameConversion ? m_changeDetector.changedRegion(m_frame)
+                                                   : QRegion(QRect(QPoint(0, 0), sourceSize));
+            if (changed.isEmpty() && sameConversion) {
+                m_staticFrames.fetchAndAddRelaxed(1);
+                continue;
             }
-            m_bufferMutex.unlock();
-            break;
-        }
 
-        case STATE_READING_PACKET_PAYLOAD: {
-            if (m_payloadSize > 0 && bufferSize >= static_cast<int>(m_payloadSize)) {
-                // Copy payload data while locked
-                QByteArray payloadData = m_buffer.left(m_payloadSize);
-                m_buffer.remove(0, m_payloadSize);
-                m_state = STATE_READING_PACKET_HEADER;
-                m_payloadSize = 0;
-                progress = true;
-                m_bufferMutex.unlock();
-                // ✅ OPTIMIZATION: Decode immediately without queuing
-                if (av_new_packet(m_packet, payloadData.size()) >= 0) {
-                    memcpy(m_packet->data, payloadData.constData(), payloadData.size());
-
-                    // ✅ NEW: Set packet flags for immediate decoding
-                    m_packet->flags |= AV_PKT_FLAG_KEY; // Hint: treat as keyframe for faster decode
-                    if (avcodec_send_packet(m_codecContext, m_packet) >= 0) {
-                        // ✅ CRITICAL: Process ALL available frames immediately
-                        int frameCount = 0;
-                        while (avcodec_receive_frame(m_codecContext, m_frame) == 0) {
-                            QImage image = convertFrameToImage(m_frame);
-                            if (!image.isNull()) {
-                                emit frameDecoded(image);
-                                frameCount++;
-                            }
-                        }
-                    #ifdef QT_DEBUG
-                        if (frameCount > 1) {
-                            qDebug() << "[Decoder] Processed" << frameCount << "frames in one packet";
-                        }
-                    #endif
-                    }
-                    av_packet_unref(m_packet);
+            DecodedFrame decoded;
+            decoded.timing.decodedUs = LatencyTracker::nowUs();
+            decoded.image = convertFrameToImage(m_frame);
+            if (!decoded.image.isNull()) {
+                // The target size may have changed since it was read above
+                decoded.dirtyRegion = (sameConversion && decoded.image.size() == outputSize)
+                    ? dirtyRegionFor(changed, sourceSize, outputSize) : QRegion();
+                m_changeDetector.setReference(m_frame);
+                m_postedOutputSize = decoded.image.size();
+                m_postedSwsFlags = swsFlags;
+
+                decoded.timing.convertedUs = LatencyTracker::nowUs();
+                const qint64 sequence = static_cast<qint64>(reinterpret_cast<intptr_t>(m_frame->opaque));
+                if (sequence >= 0 && m_timingSequence - sequence <= TIMING_RING_SIZE) {
+                    const PacketTiming &packetTiming = m_timingRing[sequence % TIMING_RING_SIZE];
+                    decoded.timing.receivedUs = packetTiming.receivedUs;
+                    decoded.timing.parsedUs = packetTiming.parsedUs;
+                }
+                decoded.sourceSize = sourceSize;
+                decoded.pts = (m_frame->pts != AV_NOPTS_VALUE) ? m_frame->pts : -1;
+                if (m_mailbox.post(std::move(decoded))) {
+                    emit frameAvailable();
                 }
-            } else {
-                m_bufferMutex.unlock();
+                frameCount++;
             }
-            break;
         }
-
-        default:
-            m_bufferMutex.unlock();
-            break;
+        if (received != AVERROR(EAGAIN) && received != AVERROR_EOF) {
+            char error[AV_ERROR_MAX_STRING_SIZE] = {};
+            av_strerror(received, error, sizeof(error));
+            startRecovery(QString("Decoding failed: %1").arg(error));
+        }
+    #ifdef QT_DEBUG
+        if (frameCount > 1) {
+            qDebug() << "[Decoder] Processed" << frameCount << "frames in one packet";
         }
+    #endif
+    }
+    av_packet_unref(m_packet);
+}
+
+void VideoDecoderThread::processBuffer(const uchar *data, qint64 size)
+{
+    m_lastReadUs = LatencyTracker::nowUs();
+    while (size > 0 && mRunning && !m_streamFailed) {
+        qint64 capacity = 0;
+        uchar *region = acquireWriteRegion(&capacity);
+
+        const qint64 chunk = qMin(size, capacity);
+        memcpy(region, data, static_cast<size_t>(chunk));
+        data += chunk;
+        size -= chunk;
+
+        commitWrite(chunk);
     }
 }
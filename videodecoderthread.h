@@ -4,12 +4,25 @@
 #include <QThread>
 #include <QImage>
 #include <QByteArray>
+#include <QAtomicInteger>
 #include <QMutex>
+#include <QSharedPointer>
+#include "framepool.h"
+#include "framemailbox.h"
+#include "decoderprofile.h"
+#include "decoderthreadbudget.h"
+#include "framechangedetector.h"
 
 // Forward declarations
+class QTcpSocket;
+class StreamCapture;
+class StreamRecorder;
+struct AVCodec;
 struct AVCodecContext;
 struct AVFrame;
 struct AVPacket;
+struct AVBufferRef;
+struct AVBufferPool;
 struct SwsContext;
 
 /**
@@ -25,23 +38,184 @@ public:
 
     void stop();
 
+    /**
+     * @brief Hands a connected video socket over to the decoder thread.
+     *
+     * The socket is moved to this thread and read there directly into the
+     * demux buffers, so the GUI thread is no longer on the video data path.
+     * Must be called from the socket's current thread; the decoder takes
+     * ownership and deletes the socket when the thread exits.
+     *
+     * Attaching again after a reconnect replaces the old socket and starts a
+     * new stream: the parser starts over and decoding resumes at the first key
+     * frame, with the codec, frame pool and last frame kept. The new stream's
+     * timestamps start over too, so it goes into @p recorder (may be null)
+     * instead of the previous recording, and a capture ends with the first stream.
+     */
+    void attachSocket(QTcpSocket *socket, const QSharedPointer<StreamRecorder> &recorder);
+
+    /**
+     * @brief Sets the size frames are converted to, normally the size of the video viewport.
+     *
+     * Frames are scaled down inside the decoder so that only the visible number of
+     * pixels is converted and handed to the GUI; they are never scaled up.
+     * An empty size selects the full decoded resolution. Thread-safe.
+     * @param size In device pixels, i.e. the viewport's size times @p devicePixelRatio.
+     * @param devicePixelRatio Set on the converted images, so they are painted 1:1 on HiDPI screens.
+     */
+    void setTargetSize(const QSize &size, qreal devicePixelRatio = 1.0);
+
+    /**
+     * @brief Selects the swscale filter used for the conversion: "fast", "bilinear" or "bicubic". Thread-safe.
+     */
+    void setScaleQuality(const QString &quality);
+
+    /**
+     * @brief Turns conversion and delivery of frames on or off, e.g. while the window is hidden. Thread-safe.
+     *
+     * While off, packets are still decoded so the reference chain stays intact,
+     * but frames are neither converted nor posted, and with @p skipNonReference
+     * frames that no other frame refers to are not decoded at all. Once back on,
+     * the next decoded frame is delivered as usual; grabViewportFrame() shows the
+     * latest one right away.
+     */
+    void setPresentationEnabled(bool enabled, bool skipNonReference = false);
+
+    /**
+     * @brief Selects the latency-versus-throughput trade-offs (threading, codec flags,
+     *        loop filter, display queue) of the decoder. Call before start().
+     */
+    void setProfile(const DecoderProfile &profile);
+
+    /**
+     * @brief Tees the raw socket bytes into a capture file for replay. Call before start().
+     */
+    void setCapture(const QSharedPointer<StreamCapture> &capture) { m_capture = capture; }
+
+    /**
+     * @brief Converts the most recently decoded frame at its full resolution, e.g. for screenshots.
+     *
+     * Thread-safe; the conversion runs on the calling thread.
+     * @return The frame, or a null image if nothing has been decoded yet.
+     */
+    QImage grabFullResolutionFrame();
+
+    /**
+     * @brief Converts the most recently decoded frame at the target size, e.g. to resume presenting at once.
+     *
+     * Thread-safe; the conversion runs on the calling thread.
+     * @return The frame, or a null image if nothing has been decoded yet.
+     */
+    QImage grabViewportFrame();
+
+    /**
+     * @brief Frames decoded so far, whether or not they were converted and presented. Thread-safe.
+     */
+    quint64 decodedFrames() const { return m_decodedFrames.loadRelaxed(); }
+
+    /**
+     * @brief Decoded frames identical to the one on screen, which were neither converted nor presented. Thread-safe.
+     */
+    quint64 staticFrames() const { return m_staticFrames.loadRelaxed(); }
+
+    /**
+     * @brief Decode errors, corrupt frames and stream resynchronisations so far, each starting a recovery. Thread-safe.
+     */
+    quint64 decodeErrors() const { return m_decodeErrors.loadRelaxed(); }
+
+    /**
+     * @brief Number of decoded frames not converted because the display still held every pooled buffer.
+     */
+    quint64 droppedFrames() const { return m_framePool.droppedFrames(); }
+
+    /**
+     * @brief Video socket bytes received so far, including the protocol framing. Thread-safe.
+     */
+    quint64 receivedBytes() const { return m_receivedBytes.loadRelaxed(); }
+
+    /**
+     * @brief Converted frames currently held in the mailbox, by the display or by the converter.
+     */
+    int framesInFlight() const { return m_framePool.inUse(); }
+
+    /**
+     * @brief Takes the next converted frame. Call after frameAvailable(), until it
+     *        returns false when the profile queues several frames; thread-safe.
+     * @return False if no new frame is pending.
+     */
+    bool takeFrame(DecodedFrame *frame) { return m_mailbox.take(frame); }
+
+    /**
+     * @brief The mailbox frames are delivered through, for its produced/presented/dropped counters.
+     */
+    const FrameMailbox &mailbox() const { return m_mailbox; }
+
 public slots:
     void decodeData(const QByteArray &data);
 
 signals:
-    void frameDecoded(const QImage &frame);
+    /**
+     * @brief Emitted when a frame was posted to an empty mailbox; fetch it with takeFrame().
+     *
+     * Frames posted before the receiver takes the pending one replace it, so
+     * a busy receiver gets one notification and always sees the newest frame.
+     */
+    void frameAvailable();
     void decodingFinished(const QString &message);
     void deviceNameReady(const QString &name);
+    /**
+     * @brief Emitted on a fatal error. Once a stream was attached, it is dropped and socketDisconnected() follows.
+     */
     void errorOccurred(const QString &error);
+    void socketDisconnected();
+
+    /**
+     * @brief Emitted when decoding cannot continue before a key frame; the receiver should ask the server for one.
+     *
+     * Repeated at most once per KEYFRAME_REQUEST_INTERVAL_US while none arrives.
+     */
+    void keyFrameRequested();
 
 protected:
     void run() override;
 
 private:
-    void processBuffer();
+    // bench/ drives the parser, decoder and converter directly, without a thread or socket
+    friend class DecoderBenchmark;
+
+    void processBuffer(const uchar *data, qint64 size);
+    void readFromSocket();
     bool initializeDecoder();
+    bool openCodec(const AVCodec *codec);
+    // Reopens the codec if the budget changed this session's threads; only safe before a key frame
+    bool rebalanceThreads();
     void cleanup();
     QImage convertFrameToImage(AVFrame* frame);
+    QImage grabLatestFrame(bool fullResolution);
+    QSize outputSizeFor(int width, int height) const;
+    QRegion dirtyRegionFor(const QRegion &changed, const QSize &sourceSize, const QSize &outputSize) const;
+
+    // Zero-copy demuxing: incoming bytes are written directly where the parser
+    // needs them (small headers into m_headerBuffer, payloads into a pooled
+    // AVBufferRef), so a packet payload is copied exactly once.
+    uchar *acquireWriteRegion(qint64 *capacity);
+    void commitWrite(qint64 bytes);
+    bool handleHeader();
+    bool allocatePayloadBuffer(quint32 size);
+    void decodePayload();
+    int headerSizeForState(int state) const;
+    void prependStreamConfig();
+    void resetStream();
+    void resetParser();
+    // Closes a stream that failed for good, so the window treats it as a lost connection
+    void dropStream();
+
+    // Error recovery: after a decode error or a resync, packets are dropped
+    // until the next key frame, which the server is asked to send right away
+    void startRecovery(const QString &reason);
+    void requestKeyFrame();
+    bool isPlausiblePacketHeader(quint64 ptsAndFlags, quint32 size) const;
+    bool resyncPacketHeader();
 
     // Inline helpers for better performance
     inline bool validateResolution(quint32 w, quint32 h) const {
@@ -55,17 +229,60 @@ private:
     // Use simple bool instead of QAtomicInt
     volatile bool mRunning;
 
-    // Mutex only for buffer access (minimal locking)
-    QMutex m_bufferMutex;
-
-
+    const AVCodec *m_codec = nullptr;  // Reopened on the next stream if a reopen failed
     AVCodecContext *m_codecContext = nullptr;
     AVFrame *m_frame = nullptr;
     AVPacket *m_packet = nullptr;
     SwsContext *m_swsContext = nullptr;
+    QTcpSocket *m_videoSocket = nullptr; // Owned and used by the decoder thread only
     QString mCodecName;
     int m_lastFrameWidth = 0;
     int m_lastFrameHeight = 0;
+    int m_lastFrameFormat = -1;
+    QSize m_lastOutputSize;
+    int m_lastSwsFlags = 0;
+    int m_lastKernelFormat = -1;          // Last frame converted by YuvConverter, for logging
+    QSize m_lastKernelOutputSize;
+
+    // Conversion target, written by the GUI thread. Packed as (width << 32 | height), 0 = full resolution.
+    QAtomicInteger<quint64> m_targetSize;
+    QAtomicInt m_targetDprPermille{1000};  // Device pixel ratio of the target, in thousandths
+    QAtomicInt m_swsFlags;
+
+    // Converted frames are written into recycled buffers: one displayed, one in the
+    // mailbox, one being converted and a spare. Frames are dropped beyond that.
+    // A deeper mailbox (see DecoderProfile) gets a slot per extra queued frame.
+    static constexpr int FRAME_POOL_SIZE = 4;
+    DecoderProfile m_profile;
+    FramePool m_framePool{FRAME_POOL_SIZE, FramePool::ExhaustionPolicy::DropFrame};
+    FrameMailbox m_mailbox;
+    QAtomicInteger<quint64> m_receivedBytes{0};
+    QAtomicInteger<quint64> m_decodedFrames{0};
+    QAtomicInteger<quint64> m_staticFrames{0};
+
+    // Static-screen detection against the frame last posted, and the
+    // conversion it was posted with (a new size or filter needs a new frame)
+    FrameChangeDetector m_changeDetector;
+    QSize m_postedOutputSize;
+    int m_postedSwsFlags = 0;
+
+    // Decode-only mode while the window is hidden, written by the GUI thread
+    QAtomicInt m_presenting{1};
+    QAtomicInt m_skipNonReference{0};
+    QAtomicInt m_presentationChanges{0};    // The GUI shows a grabbed frame after each change
+    int m_seenPresentationChanges = 0;
+
+    // Session in DecoderThreadBudget and the allocation the codec was opened with
+    int m_budgetSession = -1;
+    int m_budgetGeneration = -1;
+    bool m_budgetVisible = true;
+    DecoderThreadBudget::Allocation m_threadAllocation;
+    QSharedPointer<StreamRecorder> m_recorder;
+    QSharedPointer<StreamCapture> m_capture;
+
+    // Reference to the last decoded frame, for full-resolution snapshots
+    QMutex m_lastFrameMutex;
+    AVFrame *m_lastFrame = nullptr;
 
     enum StreamingState {
         STATE_READING_DUMMY_BYTE,
@@ -76,11 +293,58 @@ private:
     };
 
     StreamingState m_state = STATE_READING_DUMMY_BYTE;
-    QByteArray m_buffer;
     quint32 m_payloadSize = 0;
 
-    // Pre-allocate for better performance
-    static constexpr int INITIAL_BUFFER_CAPACITY = 512 * 1024; // 512KB
+    // Packet header: 8-byte PTS and flags word, then the 4-byte payload size
+    static constexpr quint64 PACKET_FLAG_CONFIG = quint64(1) << 63;
+    static constexpr quint64 PACKET_FLAG_KEY_FRAME = quint64(1) << 62;
+    static constexpr quint64 PACKET_PTS_MASK = PACKET_FLAG_KEY_FRAME - 1;
+
+    qint64 m_packetPts = -1;        // Microseconds, -1 for config packets
+    bool m_packetIsConfig = false;
+    bool m_packetIsKeyFrame = false;
+    QByteArray m_pendingConfig;     // Config packet waiting to be merged into the next packet
+    QByteArray m_streamConfig;      // Latest config, for a codec reopened mid-stream
+    bool m_packetHasConfig = false;
+    qint64 m_lastPts = -1;
+
+    // Error recovery
+    static constexpr qint64 KEYFRAME_REQUEST_INTERVAL_US = 1000000;
+    static constexpr quint32 MAX_RESYNC_BYTES = 16 * 1024 * 1024;
+    static constexpr qint64 RESYNC_PTS_WINDOW_US = 60 * 1000000LL;
+    bool m_awaitingKeyFrame = false;
+    qint64 m_lastKeyFrameRequestUs = 0;
+    bool m_resyncing = false;       // Sliding over garbage for the next plausible packet header
+    quint32 m_resyncBytes = 0;
+    bool m_streamFailed = false;    // Fatal parse or codec error; the stream is dropped after the current read
+    QAtomicInteger<quint64> m_decodeErrors{0};
+
+    // Latency tracing: the arrival and parse times of each packet are kept in a
+    // ring indexed by a sequence number that libavcodec copies from the packet's
+    // opaque value to the decoded frame's (AV_CODEC_FLAG_COPY_OPAQUE)
+    struct PacketTiming {
+        qint64 receivedUs = 0;
+        qint64 parsedUs = 0;
+    };
+    static constexpr int TIMING_RING_SIZE = 64;
+    PacketTiming m_timingRing[TIMING_RING_SIZE];
+    qint64 m_timingSequence = 0;
+    qint64 m_lastReadUs = 0;        // When the last socket read returned
+    qint64 m_packetReceivedUs = 0;  // When the current packet's header was complete
+
+    // Header staging: the largest fixed-size record is the 64-byte device meta
+    static constexpr int HEADER_BUFFER_CAPACITY = 64;
+    uchar m_headerBuffer[HEADER_BUFFER_CAPACITY];
+    int m_headerFilled = 0;
+
+    // Payload slabs are recycled through an AVBufferPool and handed to
+    // libavcodec by reference, so no per-packet malloc or extra memcpy.
+    AVBufferPool *m_packetPool = nullptr;
+    quint32 m_packetPoolSize = 0;
+    AVBufferRef *m_payloadBuffer = nullptr;
+    quint32 m_payloadFilled = 0;
+
+    static constexpr quint32 INITIAL_PACKET_POOL_SIZE = 512 * 1024; // 512KB
 };
 
 #endif // VIDEODECODERTHREAD_H
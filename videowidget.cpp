@@ -0,0 +1,156 @@
+#include "videowidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+
+VideoWidget::VideoWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    // Every pixel is painted in paintEvent(), so skip the background fill
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void VideoWidget::setFrame(const QImage &frame, const QRegion &dirtyRegion)
+{
+    if (frame.isNull()) {
+        return;
+    }
+
+    const bool sizeChanged = frame.size() != m_frame.size();
+    m_frame = frame;
+    m_text.clear();
+
+    if (m_framePending) {
+        // The scheduled repaint will pick up this newer frame instead
+        m_coalescedFrames++;
+    }
+
+    if (sizeChanged) {
+        updateVideoRect();
+        update();
+    } else if (!dirtyRegion.isEmpty() && !m_videoRect.isEmpty()) {
+        // Qt accumulates the regions of frames coalesced before the next paint
+        update(mapToVideoRect(dirtyRegion));
+    } else {
+        // Even with a repaint pending: it may only cover an earlier frame's dirty region
+        update(m_videoRect);
+    }
+    m_framePending = true;
+}
+
+QRegion VideoWidget::mapToVideoRect(const QRegion &imageRegion) const
+{
+    const qreal scaleX = qreal(m_videoRect.width()) / m_frame.width();
+    const qreal scaleY = qreal(m_videoRect.height()) / m_frame.height();
+
+    QRegion mapped;
+    for (const QRect &rect : imageRegion) {
+        // Rounded outwards, plus a pixel for the reach of the scaling filter
+        const QRect target = QRectF(rect.x() * scaleX, rect.y() * scaleY,
+                                    rect.width() * scaleX, rect.height() * scaleY).toAlignedRect();
+        mapped += target.adjusted(-1, -1, 1, 1).translated(m_videoRect.topLeft()) & m_videoRect;
+    }
+    return mapped;
+}
+
+void VideoWidget::setText(const QString &text)
+{
+    m_text = text;
+    m_frame = QImage();
+    m_framePending = false;
+    updateVideoRect();
+    update();
+}
+
+void VideoWidget::setSmoothScaling(bool enabled)
+{
+    if (m_smoothScaling != enabled) {
+        m_smoothScaling = enabled;
+        update();
+    }
+}
+
+QSize VideoWidget::sizeHint() const
+{
+    return m_frame.isNull() ? QSize(360, 640) : m_frame.deviceIndependentSize().toSize();
+}
+
+QSize VideoWidget::pixelSize() const
+{
+    const qreal ratio = devicePixelRatioF();
+    return QSize(qRound(width() * ratio), qRound(height() * ratio));
+}
+
+bool VideoWidget::event(QEvent *event)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    // Moved to a screen with another scale factor: frames should be converted for it
+    if (event->type() == QEvent::DevicePixelRatioChange) {
+        emit viewportResized(size());
+    }
+#endif
+    return QWidget::event(event);
+}
+
+void VideoWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+
+    if (m_frame.isNull()) {
+        painter.fillRect(rect(), Qt::black);
+        if (!m_text.isEmpty()) {
+            painter.setPen(Qt::white);
+            painter.drawText(rect(), Qt::AlignCenter | Qt::TextWordWrap, m_text);
+        }
+        return;
+    }
+
+    // Only the letterbox bars around the video need filling
+    const QRegion bars = QRegion(event->rect()) - m_videoRect;
+    for (const QRect &bar : bars) {
+        painter.fillRect(bar, Qt::black);
+    }
+
+    if (m_videoRect.intersects(event->rect())) {
+        // Compared in device pixels: frames are converted for the screen's scale factor
+        const qreal ratio = devicePixelRatioF();
+        if (QSize(qRound(m_videoRect.width() * ratio), qRound(m_videoRect.height() * ratio)) == m_frame.size()
+            && qFuzzyCompare(m_frame.devicePixelRatio(), ratio)) {
+            // 1:1 - a plain blit, no scaling
+            painter.drawImage(m_videoRect.topLeft(), m_frame);
+        } else {
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, m_smoothScaling);
+            painter.drawImage(m_videoRect, m_frame);
+        }
+    }
+
+    if (m_framePending) {
+        m_framePending = false;
+        m_presentedFrames++;
+        emit framePresented();
+    }
+}
+
+void VideoWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateVideoRect();
+    emit viewportResized(event->size());
+}
+
+void VideoWidget::updateVideoRect()
+{
+    if (m_frame.isNull()) {
+        m_videoRect = rect();
+        return;
+    }
+
+    // Fit the frame into the widget keeping its aspect ratio, centered
+    QSize videoSize = m_frame.size();
+    videoSize.scale(size(), Qt::KeepAspectRatio);
+    m_videoRect = QRect(QPoint((width() - videoSize.width()) / 2,
+                               (height() - videoSize.height()) / 2),
+                        videoSize);
+}
@@ -0,0 +1,109 @@
+#ifndef VIDEOWIDGET_H
+#define VIDEOWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QRect>
+#include <QRegion>
+
+/**
+ * @file videowidget.h
+ * @brief Defines the VideoWidget class, which paints decoded video frames.
+ */
+
+/**
+ * @class VideoWidget
+ * @brief Paints the most recent video frame, letterboxed to the widget's size.
+ *
+ * Replaces the QLabel + QPixmap path, which converted every frame to a pixmap
+ * and rescaled the full frame on the GUI thread:
+ * - The QImage is drawn directly in paintEvent(), scaled only to the visible rectangle.
+ * - Frames arriving faster than the display repaints replace the pending one
+ *   instead of queueing repaints (only the latest frame is ever painted).
+ * - Only the frame's dirty region is repainted when the decoder reports one.
+ * - The frame is held by implicit sharing, so no per-frame copy is made here.
+ * - The widget is opaque, so Qt skips clearing the background behind it.
+ *
+ * When no frame is shown, a status text is painted instead (see setText()).
+ */
+class VideoWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit VideoWidget(QWidget *parent = nullptr);
+
+    /**
+     * @brief Schedules a frame for display. Replaces any frame not painted yet.
+     * @param dirtyRegion What changed since the previous frame, in @p frame's pixels;
+     *        empty to repaint the whole frame.
+     */
+    void setFrame(const QImage &frame, const QRegion &dirtyRegion = QRegion());
+
+    /**
+     * @brief Clears the frame and shows a status message instead.
+     */
+    void setText(const QString &text);
+
+    /**
+     * @brief Returns the last frame given to setFrame(), or a null image while a text is shown.
+     */
+    QImage currentFrame() const { return m_frame; }
+
+    /**
+     * @brief Returns true while a frame given to setFrame() has not been painted yet.
+     */
+    bool isFramePending() const { return m_framePending; }
+
+    /**
+     * @brief Returns the rectangle, in widget coordinates, the current frame is painted into.
+     */
+    QRect videoRect() const { return m_videoRect; }
+
+    /**
+     * @brief Enables bilinear filtering when the frame has to be scaled. Enabled by default.
+     */
+    void setSmoothScaling(bool enabled);
+
+    // Statistics: frames painted, and frames replaced before they could be painted
+    quint64 presentedFrames() const { return m_presentedFrames; }
+    quint64 coalescedFrames() const { return m_coalescedFrames; }
+
+    /**
+     * @brief Returns the widget's size in device pixels, the resolution frames are best converted to.
+     */
+    QSize pixelSize() const;
+
+    QSize sizeHint() const override;
+
+signals:
+    /**
+     * @brief Emitted when the widget's size or device pixel ratio changes, so frame-to-widget
+     *        mappings and the conversion size (see pixelSize()) can be refreshed.
+     */
+    void viewportResized(const QSize &size);
+
+    /**
+     * @brief Emitted from paintEvent() after a frame given to setFrame() has been painted.
+     */
+    void framePresented();
+
+protected:
+    bool event(QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void updateVideoRect();
+    QRegion mapToVideoRect(const QRegion &imageRegion) const;
+
+    QImage m_frame;
+    QString m_text;
+    QRect m_videoRect;
+    bool m_framePending = false;
+    bool m_smoothScaling = true;
+
+    quint64 m_presentedFrames = 0;
+    quint64 m_coalescedFrames = 0;
+};
+
+#endif // VIDEOWIDGET_H
@@ -0,0 +1,242 @@
+#include "yuvconverter.h"
+#include "threadpolicy.h"
+#include "yuvkernels.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <functional>
+
+extern "C" {
+#include <libavutil/cpu.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+
+using namespace YuvKernels;
+
+QAtomicInt s_enabled{1};
+
+const KernelTable *selectKernels()
+{
+    const int flags = av_get_cpu_flags();
+    const KernelTable *kernels = nullptr;
+    // The stores write the RGB32 bytes in little-endian order
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    Q_UNUSED(flags);
+#elif defined(Q_PROCESSOR_X86)
+    if ((flags & AV_CPU_FLAG_AVX2) && avx2Kernels()) {
+        kernels = avx2Kernels();
+    } else if ((flags & AV_CPU_FLAG_SSE4) && sse41Kernels()) {
+        kernels = sse41Kernels();
+    }
+#elif defined(Q_PROCESSOR_ARM)
+    if ((flags & AV_CPU_FLAG_NEON) && neonKernels()) {
+        kernels = neonKernels();
+    }
+#else
+    Q_UNUSED(flags);
+#endif
+    return kernels;
+}
+
+const KernelTable *kernels()
+{
+    static const KernelTable *selected = selectKernels();
+    return selected;
+}
+
+bool layoutFor(int format, Layout *layout)
+{
+    switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+        *layout = Planar8;
+        return true;
+    case AV_PIX_FMT_NV12:
+        *layout = SemiPlanar8;
+        return true;
+    case AV_PIX_FMT_YUV420P10LE:
+        *layout = Planar10;
+        return true;
+    default:
+        return false;
+    }
+}
+
+int16_t q15(double value)
+{
+    return static_cast<int16_t>(qRound(value * 32768.0));
+}
+
+Matrix matrixFor(const AVFrame *frame, Layout layout)
+{
+    // Luma weights of the colorspace; anything untagged is treated as BT.601, like swscale does
+    double kr = 0.299;
+    double kb = 0.114;
+    if (frame->colorspace == AVCOL_SPC_BT709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    } else if (frame->colorspace == AVCOL_SPC_BT2020_NCL || frame->colorspace == AVCOL_SPC_BT2020_CL) {
+        kr = 0.2627;
+        kb = 0.0593;
+    }
+    const double kg = 1.0 - kr - kb;
+
+    const bool fullRange = frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P;
+    const double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+    const double cScale = fullRange ? 1.0 : 255.0 / 224.0;
+    const int depthShift = (layout == Planar10) ? 2 : 0;
+
+    Matrix matrix;
+    matrix.yOffset = static_cast<int16_t>((fullRange ? 0 : 16) << depthShift);
+    matrix.cOffset = static_cast<int16_t>(128 << depthShift);
+    matrix.yGain = q15(yScale - 1.0);
+    matrix.rv = q15(2.0 * (1.0 - kr) * cScale - 1.0);
+    matrix.gu = q15(-2.0 * kb * (1.0 - kb) / kg * cScale);
+    matrix.gv = q15(-2.0 * kr * (1.0 - kr) / kg * cScale);
+    matrix.bu = q15(2.0 * (1.0 - kb) * cScale - 2.0);
+    return matrix;
+}
+
+QThreadPool *conversionPool()
+{
+    // Shared by all decoders: a few helpers are enough to split a frame, and
+    // more would only compete with the decoders' own threads
+    static QThreadPool *pool = [] {
+        QThreadPool *threadPool = new QThreadPool;
+        threadPool->setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 4, 3));
+        return threadPool;
+    }();
+    return pool;
+}
+
+// Bands are claimed from a shared counter by the caller and the helpers alike
+struct BandJob
+{
+    std::function<void(int)> convertBand;
+    int bands = 0;
+    QAtomicInt next{0};
+    QAtomicInt remaining{0};
+    QMutex mutex;
+    QWaitCondition finished;
+
+    void run()
+    {
+        forever {
+            const int band = next.fetchAndAddRelaxed(1);
+            if (band >= bands) {
+                return;
+            }
+            convertBand(band);
+            if (remaining.fetchAndAddOrdered(-1) == 1) {
+                QMutexLocker locker(&mutex);
+                finished.wakeAll();
+            }
+        }
+    }
+};
+
+} // namespace
+
+bool YuvConverter::canConvert(const AVFrame *frame, const QSize &outputSize)
+{
+    Layout layout;
+    if (!s_enabled.loadRelaxed() || !kernels() || !frame || !layoutFor(frame->format, &layout)) {
+        return false;
+    }
+
+    const QSize source(frame->width, frame->height);
+    return outputSize == source
+        || (outputSize == source / 2 && !outputSize.isEmpty());
+}
+
+void YuvConverter::convert(const AVFrame *frame, QImage &image)
+{
+    Layout layout = Planar8;
+    layoutFor(frame->format, &layout);
+
+    const bool half = image.size() != QSize(frame->width, frame->height);
+    const RowFunction convertRow = half ? kernels()->halfSize[layout] : kernels()->fullSize[layout];
+    const Matrix matrix = matrixFor(frame, layout);
+    const int width = image.width();
+    const int height = image.height();
+    // Taken once: the bands write through these, never through the shared QImage
+    uchar *bits = image.bits();
+    const qsizetype stride = image.bytesPerLine();
+
+    auto convertRows = [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const int lumaRow = half ? 2 * y : y;
+            const int chromaRow = half ? y : y / 2;
+            Row row;
+            row.y0 = frame->data[0] + qptrdiff(lumaRow) * frame->linesize[0];
+            row.y1 = half ? row.y0 + frame->linesize[0] : nullptr;
+            row.u = frame->data[1] + qptrdiff(chromaRow) * frame->linesize[1];
+            row.v = (layout == SemiPlanar8) ? nullptr : frame->data[2] + qptrdiff(chromaRow) * frame->linesize[2];
+            row.dst = reinterpret_cast<uint32_t*>(bits + y * stride);
+            row.width = width;
+            convertRow(row, matrix);
+        }
+    };
+
+    const int maxBands = conversionPool()->maxThreadCount() + 1;
+    const int bands = (width * height >= PARALLEL_MIN_PIXELS) ? qMin(maxBands, height / MIN_BAND_ROWS) : 1;
+    if (bands <= 1) {
+        convertRows(0, height);
+        return;
+    }
+
+    // The job outlives this call if a helper starts late; by then every band is
+    // claimed, so the helper returns without touching the frame or the image
+    QSharedPointer<BandJob> job = QSharedPointer<BandJob>::create();
+    job->convertBand = [&convertRows, bands, height](int band) {
+        convertRows(height * band / bands, height * (band + 1) / bands);
+    };
+    job->bands = bands;
+    job->remaining.storeRelaxed(bands);
+
+    for (int i = 1; i < bands; ++i) {
+        conversionPool()->start([job]() {
+            // Pool threads are created by whichever decoder starts a job first,
+            // and would keep its real-time class, niceness and CPUs
+            thread_local bool reset = false;
+            if (!reset) {
+                ThreadPolicy::instance().resetCurrentThread();
+                reset = true;
+            }
+            job->run();
+        });
+    }
+    job->run();
+
+    QMutexLocker locker(&job->mutex);
+    while (job->remaining.loadAcquire() > 0) {
+        job->finished.wait(&job->mutex);
+    }
+}
+
+const char *YuvConverter::kernelName()
+{
+    return (s_enabled.loadRelaxed() && kernels()) ? kernels()->name : "swscale";
+}
+
+QStringList YuvConverter::compiledKernels()
+{
+    QStringList names;
+    for (const KernelTable *table : {avx2Kernels(), sse41Kernels(), neonKernels()}) {
+        if (table) {
+            names.append(QString::fromLatin1(table->name));
+        }
+    }
+    return names;
+}
+
+void YuvConverter::setEnabled(bool enabled)
+{
+    s_enabled.storeRelaxed(enabled ? 1 : 0);
+}
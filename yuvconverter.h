@@ -0,0 +1,68 @@
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <QImage>
+#include <QSize>
+#include <QStringList>
+
+struct AVFrame;
+
+/**
+ * @file yuvconverter.h
+ * @brief Defines the YuvConverter class, vectorized YUV to RGB32 conversion of decoded frames.
+ */
+
+/**
+ * @class YuvConverter
+ * @brief Converts the decoders' output formats to QImage::Format_RGB32 with SIMD row kernels.
+ *
+ * Handles yuv420p, yuvj420p, nv12 and yuv420p10le (HEVC Main 10), at the
+ * frame's size or fused with an exact 2:1 downscale (2x2 box filter). The
+ * kernels (see yuvkernels.h) are picked once at runtime: AVX2 or SSE4.1 on
+ * x86, NEON on AArch64. The matrix follows the frame's colorspace (BT.601,
+ * BT.709, BT.2020) and range.
+ *
+ * Large frames are split into bands of rows that run on a small shared
+ * worker pool, with the calling thread converting bands as well, so a busy
+ * pool never delays a conversion beyond doing it alone.
+ *
+ * Anything else (other formats or scale factors, or a CPU without the
+ * instruction sets) is left to swscale by the caller. Thread-safe.
+ */
+class YuvConverter
+{
+public:
+    /**
+     * @brief Whether convert() handles @p frame into an image of @p outputSize.
+     */
+    static bool canConvert(const AVFrame *frame, const QSize &outputSize);
+
+    /**
+     * @brief Converts @p frame into @p image, which must be RGB32 and pass canConvert().
+     */
+    static void convert(const AVFrame *frame, QImage &image);
+
+    /**
+     * @brief Name of the kernels in use, e.g. "avx2", or "swscale" if there are none.
+     */
+    static const char *kernelName();
+
+    /**
+     * @brief Names of the kernels built into this binary, whether or not the CPU can run them.
+     */
+    static QStringList compiledKernels();
+
+    /**
+     * @brief Turns the kernels off so every frame goes through swscale, e.g. to compare the two.
+     */
+    static void setEnabled(bool enabled);
+
+private:
+    YuvConverter() = delete;
+
+    // Frames below this many output pixels are converted on the calling thread alone
+    static constexpr int PARALLEL_MIN_PIXELS = 1280 * 720;
+    static constexpr int MIN_BAND_ROWS = 90;
+};
+
+#endif // YUVCONVERTER_H
@@ -0,0 +1,75 @@
+#ifndef YUVKERNELS_H
+#define YUVKERNELS_H
+
+#include <cstdint>
+
+/**
+ * @file yuvkernels.h
+ * @brief Row kernels converting decoder output (YUV 4:2:0) to RGB32, per instruction set.
+ *
+ * Internal to YuvConverter. The kernels are plain C++ without Qt, one
+ * translation unit per instruction set, each compiled with its own flags
+ * (see the SSE4_1_SOURCES / AVX2_SOURCES in the .pro file). Row tails
+ * narrower than a vector use a scalar version of the same arithmetic, and
+ * every instruction set computes bit-identical output.
+ */
+
+namespace YuvKernels {
+
+enum Layout {
+    Planar8,      // yuv420p, yuvj420p: Y, U and V planes, 8-bit
+    SemiPlanar8,  // nv12: Y plane and an interleaved UV plane, 8-bit
+    Planar10,     // yuv420p10le: Y, U and V planes, 10-bit in 16-bit little-endian words
+    LAYOUT_COUNT
+};
+
+/**
+ * @brief YUV to RGB matrix in the kernels' 16-bit fixed point.
+ *
+ * Samples are scaled to 1/64 units of an 8-bit value; the fractional parts
+ * of the gains are Q15 factors for a rounding high multiply, the integer
+ * parts are added separately (R = Y + V + rv*V, B = Y + 2U + bu*U).
+ */
+struct Matrix {
+    int16_t yOffset;  // Black level, in the layout's bit depth
+    int16_t cOffset;  // Chroma zero, in the layout's bit depth
+    int16_t yGain;    // Y  * (1 + yGain)
+    int16_t rv;       // V  * (1 + rv)
+    int16_t gu;       // U  * gu (negative)
+    int16_t gv;       // V  * gv (negative)
+    int16_t bu;       // U  * (2 + bu)
+};
+
+/**
+ * @brief One output row: source rows in, RGB32 pixels out.
+ *
+ * At full size, chroma sample x/2 serves output pixel x. For the fused 2:1
+ * downscale, output pixel x averages the 2x2 luma block at (2x, 2y) of
+ * @c y0 / @c y1 and takes chroma sample x as is.
+ */
+struct Row {
+    const uint8_t *y0;  // Luma row
+    const uint8_t *y1;  // Second luma row (2:1 only)
+    const uint8_t *u;   // U row, or the interleaved UV row for SemiPlanar8
+    const uint8_t *v;   // V row (planar layouts)
+    uint32_t *dst;      // 0xffRRGGBB, as QImage::Format_RGB32
+    int width;          // Output pixels
+};
+
+using RowFunction = void (*)(const Row &row, const Matrix &matrix);
+
+struct KernelTable {
+    const char *name;
+    RowFunction fullSize[LAYOUT_COUNT];
+    RowFunction halfSize[LAYOUT_COUNT];
+};
+
+// nullptr when the build has no kernels for the instruction set; the
+// caller checks that the CPU supports it before using a table
+const KernelTable *sse41Kernels();
+const KernelTable *avx2Kernels();
+const KernelTable *neonKernels();
+
+} // namespace YuvKernels
+
+#endif // YUVKERNELS_H
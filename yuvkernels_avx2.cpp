@@ -0,0 +1,105 @@
+#include "yuvkernels_impl.h"
+
+// Compiled with AVX2 enabled (AVX2_SOURCES); used only after a CPU check
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace YuvKernels {
+namespace {
+
+// 256-bit pack and unpack instructions work within 128-bit halves; the loads
+// and the store below put the 16 lanes back into pixel order where needed
+struct Avx2Ops
+{
+    using V = __m256i;
+    static constexpr int Lanes = 16;
+
+    static V set1(int16_t x) { return _mm256_set1_epi16(x); }
+    static V sub(V a, V b) { return _mm256_sub_epi16(a, b); }
+    static V adds(V a, V b) { return _mm256_adds_epi16(a, b); }
+    template<int N> static V shl(V a) { return _mm256_slli_epi16(a, N); }
+    template<int N> static V sar(V a) { return _mm256_srai_epi16(a, N); }
+    static V mulhrs(V a, V b) { return _mm256_mulhrs_epi16(a, b); }
+
+    static __m128i load64(const uint8_t *p) { return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)); }
+    static __m128i load128(const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static V load256(const uint8_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+    static V loadU8(const uint8_t *p) { return _mm256_cvtepu8_epi16(load128(p)); }
+    static V loadU16(const uint8_t *p) { return load256(p); }
+
+    static V loadU8Dup(const uint8_t *p)
+    {
+        const __m128i x = load64(p);
+        return _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(x, x));
+    }
+
+    static V loadU16Dup(const uint8_t *p)
+    {
+        const __m128i x = load128(p);
+        return _mm256_set_m128i(_mm_unpackhi_epi16(x, x), _mm_unpacklo_epi16(x, x));
+    }
+
+    static void loadNV12(const uint8_t *p, V &u, V &v)
+    {
+        const V x = load256(p);
+        u = _mm256_and_si256(x, _mm256_set1_epi16(0x00ff));
+        v = _mm256_srli_epi16(x, 8);
+    }
+
+    static void loadNV12Dup(const uint8_t *p, V &u, V &v)
+    {
+        // u0 v0 .. u7 v7 -> u0 .. u7 v0 .. v7, then each byte twice
+        const __m128i planar = _mm_shuffle_epi8(load128(p), _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                                          1, 3, 5, 7, 9, 11, 13, 15));
+        u = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(planar, planar));
+        v = _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(planar, planar));
+    }
+
+    static V loadU8Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const V rows = _mm256_avg_epu8(load256(r0), load256(r1));
+        const V pairs = _mm256_maddubs_epi16(rows, _mm256_set1_epi8(1));
+        return _mm256_srli_epi16(_mm256_add_epi16(pairs, _mm256_set1_epi16(1)), 1);
+    }
+
+    static V loadU16Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const V ones = _mm256_set1_epi16(1);
+        const V low = _mm256_madd_epi16(_mm256_avg_epu16(load256(r0), load256(r1)), ones);
+        const V high = _mm256_madd_epi16(_mm256_avg_epu16(load256(r0 + 32), load256(r1 + 32)), ones);
+        // packs interleaves the halves: low0 high0 low1 high1 -> low0 low1 high0 high1
+        const V packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+        return _mm256_srli_epi16(_mm256_add_epi16(packed, ones), 1);
+    }
+
+    static void storeRGB32(uint32_t *dst, V r, V g, V b)
+    {
+        // Per 128-bit half: pixels 0-3 / 8-11 in lo, 4-7 / 12-15 in hi
+        const V bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(b, b), _mm256_packus_epi16(g, g));
+        const V ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(r, r), _mm256_set1_epi8(-1));
+        const V lo = _mm256_unpacklo_epi16(bg, ra);
+        const V hi = _mm256_unpackhi_epi16(bg, ra);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+};
+
+} // namespace
+
+const KernelTable *avx2Kernels()
+{
+    static const KernelTable table = makeTable<Avx2Ops>("avx2");
+    return &table;
+}
+
+} // namespace YuvKernels
+
+#else
+
+const YuvKernels::KernelTable *YuvKernels::avx2Kernels()
+{
+    return nullptr;
+}
+
+#endif
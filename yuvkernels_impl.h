@@ -0,0 +1,161 @@
+#ifndef YUVKERNELS_IMPL_H
+#define YUVKERNELS_IMPL_H
+
+#include "yuvkernels.h"
+#include <cstring>
+
+/**
+ * @file yuvkernels_impl.h
+ * @brief The row kernel template shared by the per-instruction-set translation units.
+ *
+ * Each unit defines an Ops struct (vector of Lanes int16 values, loads, 16-bit
+ * arithmetic and the RGB32 store) and instantiates makeTable() with it. Row
+ * tails narrower than a vector go through ScalarOps. Everything is in an
+ * anonymous namespace: the units are compiled with different instruction set
+ * flags, so none of this code may be shared between them by the linker.
+ */
+
+namespace YuvKernels {
+namespace {
+
+template<Layout L> struct LayoutTraits;
+template<> struct LayoutTraits<Planar8>     { static constexpr int SampleBytes = 1; static constexpr int Shift = 6; };
+template<> struct LayoutTraits<SemiPlanar8> { static constexpr int SampleBytes = 1; static constexpr int Shift = 6; };
+template<> struct LayoutTraits<Planar10>    { static constexpr int SampleBytes = 2; static constexpr int Shift = 4; };
+
+// One pixel at a time, with the exact semantics of the vector instructions
+// (rounding high multiply, saturating add, rounding averages)
+struct ScalarOps
+{
+    using V = int;
+    static constexpr int Lanes = 1;
+
+    static int saturate(int x) { return x < -32768 ? -32768 : (x > 32767 ? 32767 : x); }
+    static int load16(const uint8_t *p) { uint16_t value; std::memcpy(&value, p, 2); return value; }
+
+    static V set1(int16_t x) { return x; }
+    static V sub(V a, V b) { return a - b; }
+    static V adds(V a, V b) { return saturate(a + b); }
+    template<int N> static V shl(V a) { return a * (1 << N); }
+    template<int N> static V sar(V a) { return a >> N; }
+    static V mulhrs(V a, V b) { return (a * b + 0x4000) >> 15; }
+
+    static V loadU8(const uint8_t *p) { return p[0]; }
+    static V loadU16(const uint8_t *p) { return load16(p); }
+    static V loadU8Dup(const uint8_t *p) { return p[0]; }
+    static V loadU16Dup(const uint8_t *p) { return load16(p); }
+    static void loadNV12(const uint8_t *p, V &u, V &v) { u = p[0]; v = p[1]; }
+    static void loadNV12Dup(const uint8_t *p, V &u, V &v) { u = p[0]; v = p[1]; }
+
+    static V loadU8Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const int left = (r0[0] + r1[0] + 1) >> 1;
+        const int right = (r0[1] + r1[1] + 1) >> 1;
+        return (left + right + 1) >> 1;
+    }
+
+    static V loadU16Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const int left = (load16(r0) + load16(r1) + 1) >> 1;
+        const int right = (load16(r0 + 2) + load16(r1 + 2) + 1) >> 1;
+        return (left + right + 1) >> 1;
+    }
+
+    static uint32_t clamp8(int x) { return static_cast<uint32_t>(x < 0 ? 0 : (x > 255 ? 255 : x)); }
+
+    static void storeRGB32(uint32_t *dst, V r, V g, V b)
+    {
+        *dst = 0xff000000u | (clamp8(r) << 16) | (clamp8(g) << 8) | clamp8(b);
+    }
+};
+
+/**
+ * @brief Converts pixels [x, row.width) in steps of Ops::Lanes; returns where it stopped.
+ */
+template<typename Ops, Layout L, bool Half>
+inline int convertPixels(const Row &row, const Matrix &matrix, int x)
+{
+    using V = typename Ops::V;
+    constexpr int Shift = LayoutTraits<L>::Shift;
+    constexpr int Bytes = LayoutTraits<L>::SampleBytes;
+
+    const V yOffset = Ops::set1(matrix.yOffset);
+    const V cOffset = Ops::set1(matrix.cOffset);
+    const V yGain = Ops::set1(matrix.yGain);
+    const V rv = Ops::set1(matrix.rv);
+    const V gu = Ops::set1(matrix.gu);
+    const V gv = Ops::set1(matrix.gv);
+    const V bu = Ops::set1(matrix.bu);
+    const V rounding = Ops::set1(32);
+
+    for (; x + Ops::Lanes <= row.width; x += Ops::Lanes) {
+        V y, u, v;
+        if constexpr (Half) {
+            const int lumaOffset = 2 * x * Bytes;
+            if constexpr (L == Planar10) {
+                y = Ops::loadU16Box(row.y0 + lumaOffset, row.y1 + lumaOffset);
+                u = Ops::loadU16(row.u + x * 2);
+                v = Ops::loadU16(row.v + x * 2);
+            } else if constexpr (L == SemiPlanar8) {
+                y = Ops::loadU8Box(row.y0 + lumaOffset, row.y1 + lumaOffset);
+                Ops::loadNV12(row.u + x * 2, u, v);
+            } else {
+                y = Ops::loadU8Box(row.y0 + lumaOffset, row.y1 + lumaOffset);
+                u = Ops::loadU8(row.u + x);
+                v = Ops::loadU8(row.v + x);
+            }
+        } else {
+            const int chroma = x / 2;
+            if constexpr (L == Planar10) {
+                y = Ops::loadU16(row.y0 + x * 2);
+                u = Ops::loadU16Dup(row.u + chroma * 2);
+                v = Ops::loadU16Dup(row.v + chroma * 2);
+            } else if constexpr (L == SemiPlanar8) {
+                y = Ops::loadU8(row.y0 + x);
+                Ops::loadNV12Dup(row.u + chroma * 2, u, v);
+            } else {
+                y = Ops::loadU8(row.y0 + x);
+                u = Ops::loadU8Dup(row.u + chroma);
+                v = Ops::loadU8Dup(row.v + chroma);
+            }
+        }
+
+        // To 1/64 units of an 8-bit sample, then the matrix
+        y = Ops::template shl<Shift>(Ops::sub(y, yOffset));
+        u = Ops::template shl<Shift>(Ops::sub(u, cOffset));
+        v = Ops::template shl<Shift>(Ops::sub(v, cOffset));
+        y = Ops::adds(y, Ops::mulhrs(y, yGain));
+
+        const V r = Ops::adds(Ops::adds(y, v), Ops::mulhrs(v, rv));
+        const V g = Ops::adds(y, Ops::adds(Ops::mulhrs(u, gu), Ops::mulhrs(v, gv)));
+        const V b = Ops::adds(Ops::adds(Ops::adds(y, u), u), Ops::mulhrs(u, bu));
+
+        Ops::storeRGB32(row.dst + x,
+                        Ops::template sar<6>(Ops::adds(r, rounding)),
+                        Ops::template sar<6>(Ops::adds(g, rounding)),
+                        Ops::template sar<6>(Ops::adds(b, rounding)));
+    }
+    return x;
+}
+
+template<typename Ops, Layout L, bool Half>
+void convertRow(const Row &row, const Matrix &matrix)
+{
+    const int x = convertPixels<Ops, L, Half>(row, matrix, 0);
+    convertPixels<ScalarOps, L, Half>(row, matrix, x);
+}
+
+template<typename Ops>
+KernelTable makeTable(const char *name)
+{
+    return KernelTable{
+        name,
+        { convertRow<Ops, Planar8, false>, convertRow<Ops, SemiPlanar8, false>, convertRow<Ops, Planar10, false> },
+        { convertRow<Ops, Planar8, true>, convertRow<Ops, SemiPlanar8, true>, convertRow<Ops, Planar10, true> },
+    };
+}
+
+} // namespace
+} // namespace YuvKernels
+
+#endif // YUVKERNELS_IMPL_H
@@ -0,0 +1,103 @@
+#include "yuvkernels_impl.h"
+
+// NEON is part of the AArch64 baseline, so no flags and no CPU check are needed
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+
+namespace YuvKernels {
+namespace {
+
+struct NeonOps
+{
+    using V = int16x8_t;
+    static constexpr int Lanes = 8;
+
+    static V widen(uint8x8_t x) { return vreinterpretq_s16_u16(vmovl_u8(x)); }
+    static V asSigned(uint16x8_t x) { return vreinterpretq_s16_u16(x); }
+
+    static V set1(int16_t x) { return vdupq_n_s16(x); }
+    static V sub(V a, V b) { return vsubq_s16(a, b); }
+    static V adds(V a, V b) { return vqaddq_s16(a, b); }
+    template<int N> static V shl(V a) { return vshlq_n_s16(a, N); }
+    template<int N> static V sar(V a) { return vshrq_n_s16(a, N); }
+    static V mulhrs(V a, V b) { return vqrdmulhq_s16(a, b); }
+
+    static uint16x8_t load16(const uint8_t *p) { return vreinterpretq_u16_u8(vld1q_u8(p)); }
+
+    static V loadU8(const uint8_t *p) { return widen(vld1_u8(p)); }
+    static V loadU16(const uint8_t *p) { return asSigned(load16(p)); }
+
+    static V loadU8Dup(const uint8_t *p)
+    {
+        uint32_t bytes;
+        std::memcpy(&bytes, p, 4);
+        const uint8x8_t x = vreinterpret_u8_u32(vdup_n_u32(bytes));
+        return widen(vzip1_u8(x, x));
+    }
+
+    static V loadU16Dup(const uint8_t *p)
+    {
+        const uint16x4_t x = vreinterpret_u16_u8(vld1_u8(p));
+        const uint16x8_t both = vcombine_u16(x, x);
+        return asSigned(vzip1q_u16(both, both));
+    }
+
+    static void loadNV12(const uint8_t *p, V &u, V &v)
+    {
+        const uint8x8x2_t uv = vld2_u8(p);
+        u = widen(uv.val[0]);
+        v = widen(uv.val[1]);
+    }
+
+    static void loadNV12Dup(const uint8_t *p, V &u, V &v)
+    {
+        const uint8x8_t x = vld1_u8(p);
+        const uint8x8_t us = vuzp1_u8(x, x);
+        const uint8x8_t vs = vuzp2_u8(x, x);
+        u = widen(vzip1_u8(us, us));
+        v = widen(vzip1_u8(vs, vs));
+    }
+
+    static V loadU8Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const uint8x16_t rows = vrhaddq_u8(vld1q_u8(r0), vld1q_u8(r1));
+        return asSigned(vrshrq_n_u16(vpaddlq_u8(rows), 1));
+    }
+
+    static V loadU16Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const uint16x8_t low = vrhaddq_u16(load16(r0), load16(r1));
+        const uint16x8_t high = vrhaddq_u16(load16(r0 + 16), load16(r1 + 16));
+        return asSigned(vcombine_u16(vrshrn_n_u32(vpaddlq_u16(low), 1),
+                                     vrshrn_n_u32(vpaddlq_u16(high), 1)));
+    }
+
+    static void storeRGB32(uint32_t *dst, V r, V g, V b)
+    {
+        uint8x8x4_t bgra;
+        bgra.val[0] = vqmovun_s16(b);
+        bgra.val[1] = vqmovun_s16(g);
+        bgra.val[2] = vqmovun_s16(r);
+        bgra.val[3] = vdup_n_u8(0xff);
+        vst4_u8(reinterpret_cast<uint8_t*>(dst), bgra);
+    }
+};
+
+} // namespace
+
+const KernelTable *neonKernels()
+{
+    static const KernelTable table = makeTable<NeonOps>("neon");
+    return &table;
+}
+
+} // namespace YuvKernels
+
+#else
+
+const YuvKernels::KernelTable *YuvKernels::neonKernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "yuvkernels_impl.h"
+
+// Compiled with SSE4.1 enabled (SSE4_1_SOURCES); used only after a CPU check.
+// MSVC has no SSE4.1 switch and never defines __SSE4_1__, but always allows
+// the intrinsics on x86
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86)))
+#include <smmintrin.h>
+
+namespace YuvKernels {
+namespace {
+
+struct Sse41Ops
+{
+    using V = __m128i;
+    static constexpr int Lanes = 8;
+
+    static V set1(int16_t x) { return _mm_set1_epi16(x); }
+    static V sub(V a, V b) { return _mm_sub_epi16(a, b); }
+    static V adds(V a, V b) { return _mm_adds_epi16(a, b); }
+    template<int N> static V shl(V a) { return _mm_slli_epi16(a, N); }
+    template<int N> static V sar(V a) { return _mm_srai_epi16(a, N); }
+    static V mulhrs(V a, V b) { return _mm_mulhrs_epi16(a, b); }
+
+    static V load64(const uint8_t *p) { return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)); }
+    static V load128(const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+    static V loadU8(const uint8_t *p) { return _mm_cvtepu8_epi16(load64(p)); }
+    static V loadU16(const uint8_t *p) { return load128(p); }
+
+    static V loadU8Dup(const uint8_t *p)
+    {
+        int32_t bytes;
+        std::memcpy(&bytes, p, 4);
+        const V x = _mm_cvtsi32_si128(bytes);
+        return _mm_cvtepu8_epi16(_mm_unpacklo_epi8(x, x));
+    }
+
+    static V loadU16Dup(const uint8_t *p)
+    {
+        const V x = load64(p);
+        return _mm_unpacklo_epi16(x, x);
+    }
+
+    static void loadNV12(const uint8_t *p, V &u, V &v)
+    {
+        const V x = load128(p);
+        u = _mm_and_si128(x, _mm_set1_epi16(0x00ff));
+        v = _mm_srli_epi16(x, 8);
+    }
+
+    static void loadNV12Dup(const uint8_t *p, V &u, V &v)
+    {
+        // u0 v0 .. u3 v3 -> u0 u1 u2 u3 v0 v1 v2 v3, then each byte twice
+        const V planar = _mm_shuffle_epi8(load64(p), _mm_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7,
+                                                                   -1, -1, -1, -1, -1, -1, -1, -1));
+        const V doubled = _mm_unpacklo_epi8(planar, planar);
+        u = _mm_cvtepu8_epi16(doubled);
+        v = _mm_cvtepu8_epi16(_mm_srli_si128(doubled, 8));
+    }
+
+    static V loadU8Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const V rows = _mm_avg_epu8(load128(r0), load128(r1));
+        const V pairs = _mm_maddubs_epi16(rows, _mm_set1_epi8(1));
+        return _mm_srli_epi16(_mm_add_epi16(pairs, _mm_set1_epi16(1)), 1);
+    }
+
+    static V loadU16Box(const uint8_t *r0, const uint8_t *r1)
+    {
+        const V ones = _mm_set1_epi16(1);
+        const V low = _mm_madd_epi16(_mm_avg_epu16(load128(r0), load128(r1)), ones);
+        const V high = _mm_madd_epi16(_mm_avg_epu16(load128(r0 + 16), load128(r1 + 16)), ones);
+        return _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(low, high), ones), 1);
+    }
+
+    static void storeRGB32(uint32_t *dst, V r, V g, V b)
+    {
+        const V bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_packus_epi16(g, g));
+        const V ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_set1_epi8(-1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+};
+
+} // namespace
+
+const KernelTable *sse41Kernels()
+{
+    static const KernelTable table = makeTable<Sse41Ops>("sse4.1");
+    return &table;
+}
+
+} // namespace YuvKernels
+
+#else
+
+const YuvKernels::KernelTable *YuvKernels::sse41Kernels()
+{
+    return nullptr;
+}
+
+#endif